@@ -0,0 +1,52 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+atomic<size_t> allocation_count = 0;
+
+namespace {
+
+void* AllocateCounted(size_t size, size_t alignment) {
+    ++allocation_count;
+    if (size == 0) {
+        size = 1;
+    }
+    // aligned_alloc needs the size to be a multiple of the alignment.
+    void* ptr = alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                    ? malloc(size)
+                    : aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!ptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+}  // namespace
+
+// The array and nothrow forms of the library forward to these, all memory is released with free.
+void* operator new(size_t size) {
+    return AllocateCounted(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(size_t size, align_val_t alignment) {
+    return AllocateCounted(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t, align_val_t) noexcept {
+    free(ptr);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+using namespace std;
+
+// Every heap allocation of the program is counted, benchmarks report the difference.
+// The replaced operator new and delete live in their own translation unit, so the
+// compiler never pairs an inlined free with the library's operator new.
+extern atomic<size_t> allocation_count;
@@ -0,0 +1,86 @@
+#include "corpus_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+string GenerateWord(mt19937& generator, int max_length) {
+    const int length = uniform_int_distribution(1, max_length)(generator);
+    string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
+    vector<string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+SearchServer GenerateSearchServer(mt19937& generator, const vector<string>& dictionary, int document_count, int word_count) {
+    SearchServer search_server(dictionary[0]);
+    for (int i = 0; i < document_count; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, dictionary, word_count), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    return search_server;
+}
+
+ZipfWordGenerator::ZipfWordGenerator(const vector<string>& dictionary, double skew)
+    : dictionary_(dictionary) {
+    vector<double> weights(dictionary.size());
+    for (size_t rank = 0; rank < weights.size(); ++rank) {
+        weights[rank] = 1.0 / pow(rank + 1.0, skew);
+    }
+    distribution_ = discrete_distribution<int>(weights.begin(), weights.end());
+}
+
+const string& ZipfWordGenerator::operator()(mt19937& generator) {
+    return dictionary_[distribution_(generator)];
+}
+
+const string& ZipfWordGenerator::GetRanked(mt19937& generator, int first_rank, int last_rank) const {
+    return dictionary_[uniform_int_distribution<int>(first_rank, last_rank - 1)(generator)];
+}
+
+string GenerateText(mt19937& generator, ZipfWordGenerator& words, int word_count) {
+    string text;
+    for (int i = 0; i < word_count; ++i) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        text += words(generator);
+    }
+    return text;
+}
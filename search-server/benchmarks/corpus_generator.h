@@ -0,0 +1,43 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+// Synthetic corpora for benchmarks. Words are random lowercase strings,
+// documents and queries are sequences of dictionary words.
+string GenerateWord(mt19937& generator, int max_length);
+
+vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length);
+
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob = 0);
+
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count);
+
+SearchServer GenerateSearchServer(mt19937& generator, const vector<string>& dictionary, int document_count, int word_count);
+
+// Words are drawn by Zipf's law: the word of rank r is chosen with probability
+// proportional to 1 / (r + 1)^skew, so zero skew gives uniform vocabulary.
+class ZipfWordGenerator {
+public:
+    ZipfWordGenerator(const vector<string>& dictionary, double skew);
+
+    const string& operator()(mt19937& generator);
+
+    // Words of ranks in [first_rank, last_rank), chosen uniformly.
+    const string& GetRanked(mt19937& generator, int first_rank, int last_rank) const;
+
+    int GetWordCount() const {
+        return dictionary_.size();
+    }
+
+private:
+    const vector<string>& dictionary_;
+    discrete_distribution<int> distribution_;
+};
+
+string GenerateText(mt19937& generator, ZipfWordGenerator& words, int word_count);
@@ -0,0 +1,435 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "concurrent_search_server.h"
+#include "corpus_generator.h"
+#include "ingest_documents.h"
+#include "log_duration.h"
+#include "process_queries.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "sharded_search_server.h"
+
+using namespace std;
+
+// Ad hoc comparisons of implementation variants, reported to stderr.
+// Regressions are tracked with the search_server_benchmark suite.
+
+template <typename ExecutionPolicy>
+void BenchmarkFindTopDocuments(const string& mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
+    LOG_DURATION(mark);
+    double total_relevance = 0;
+    for (const string& query : queries) {
+        for (const auto& document : search_server.FindTopDocuments(policy, query)) {
+            total_relevance += document.relevance;
+        }
+    }
+    cout << mark << " total relevance: "s << total_relevance << endl;
+}
+
+void BenchmarkQueriesLoop(const string& mark, const SearchServer& search_server, const vector<string>& queries) {
+    LOG_DURATION(mark);
+    size_t document_count = 0;
+    for (const string& query : queries) {
+        document_count += search_server.FindTopDocuments(query).size();
+    }
+    cout << mark << " documents: "s << document_count << endl;
+}
+
+void BenchmarkProcessQueriesJoined(const string& mark, const SearchServer& search_server, const vector<string>& queries) {
+    LOG_DURATION(mark);
+    size_t document_count = 0;
+    for ([[maybe_unused]] const Document& document : ProcessQueriesJoined(search_server, queries)) {
+        ++document_count;
+    }
+    cout << mark << " documents: "s << document_count << endl;
+}
+
+void PrintIndexStats(const SearchServer& search_server) {
+    const IndexStats stats = search_server.GetIndexStats();
+    cout << "Index: "s << stats.word_count << " words, "s << stats.posting_count << " postings, "s
+         << stats.memory_usage << " bytes, "s
+         << static_cast<double>(stats.memory_usage) / stats.posting_count << " bytes per posting, forward index "s
+         << static_cast<double>(stats.forward_index_memory_usage) / stats.posting_count << " of them"s << endl;
+}
+
+void BenchmarkQueryAllocations(const string& mark, const SearchServer& search_server, const vector<string>& queries) {
+    size_t match_allocations = 0;
+    size_t find_allocations = 0;
+    for (const string& query : queries) {
+        size_t start_count = allocation_count;
+        (void) search_server.MatchDocument(query, 0);
+        match_allocations += allocation_count - start_count;
+        start_count = allocation_count;
+        (void) search_server.FindTopDocuments(query);
+        find_allocations += allocation_count - start_count;
+    }
+    cout << mark << " allocations per query: MatchDocument "s
+         << static_cast<double>(match_allocations) / queries.size() << ", FindTopDocuments "s
+         << static_cast<double>(find_allocations) / queries.size() << endl;
+}
+
+void BenchmarkRequestQueue(const string& mark, const SearchServer& search_server, const vector<string>& queries) {
+    LOG_DURATION(mark);
+    RequestQueue request_queue(search_server);
+    for (const string& query : queries) {
+        (void) request_queue.AddFindRequest(query);
+    }
+    cout << mark << " no result requests: "s << request_queue.GetNoResultRequests() << endl;
+}
+
+// Accumulates relevance of synthetic posting lists shaped like those of long queries.
+void BenchmarkRelevanceKernels(mt19937& generator) {
+    const int document_count = 100'000;
+    vector<vector<int>> document_ids(10);
+    vector<vector<double>> term_freqs(10);
+    for (size_t word = 0; word < document_ids.size(); ++word) {
+        for (int id = 0; id < document_count; ++id) {
+            if (generator() % 5 == 0) {
+                document_ids[word].push_back(id);
+                term_freqs[word].push_back(0.05);
+            }
+        }
+    }
+    for (const auto& [mark, level] : {pair("scalar"s, SimdLevel::SCALAR), pair("AVX2"s, SimdLevel::AVX2),
+                                      pair("AVX-512"s, SimdLevel::AVX512)}) {
+        RelevanceAccumulator accumulator(level);
+        double total_relevance = 0;
+        {
+            LOG_DURATION("Relevance accumulation "s + mark);
+            for (int query = 0; query < 100; ++query) {
+                accumulator.Reset(document_count);
+                accumulator.Exclude(document_ids[0].data(), document_ids[0].size(), 0);
+                for (size_t word = 1; word < document_ids.size(); ++word) {
+                    accumulator.Add(document_ids[word].data(), term_freqs[word].data(), document_ids[word].size(), 1.5, 0);
+                }
+                accumulator.ExtractMatched([&total_relevance](int, double relevance) {
+                    total_relevance += relevance;
+                });
+            }
+        }
+        cout << "Relevance accumulation "s << mark << " total relevance: "s << total_relevance << endl;
+    }
+}
+
+// Compares the size of the index and the query latency with and without compression.
+void BenchmarkCompressedPostings(const SearchServer& search_server, const vector<string>& queries) {
+    SearchServer compressed_server = search_server;
+    compressed_server.SetPostingsCompression(true);
+    for (const auto& [mark, server] : {pair("uncompressed"s, &search_server), pair("compressed"s, &as_const(compressed_server))}) {
+        const IndexStats stats = server->GetIndexStats();
+        cout << "Index "s << mark << ": "s << static_cast<double>(stats.memory_usage) / stats.posting_count
+             << " bytes per posting, forward index "s
+             << static_cast<double>(stats.forward_index_memory_usage) / stats.posting_count << " of them"s << endl;
+        BenchmarkFindTopDocuments("FindTopDocuments seq "s + mark, *server, queries, execution::seq);
+    }
+}
+
+// Compares predicates with the equivalent filters evaluated on the index's columns:
+// a status and rating filter, and a short list of document ids.
+void BenchmarkDocumentFilter(const SearchServer& search_server, const vector<string>& queries) {
+    DocumentFilter rating_filter;
+    rating_filter.status = DocumentStatus::ACTUAL;
+    rating_filter.min_rating = 2;
+    DocumentFilter id_filter;
+    id_filter.document_ids = vector<int>{};
+    for (int document_id = 0; document_id < search_server.GetDocumentCount(); document_id += 1'000) {
+        id_filter.document_ids->push_back(document_id);
+    }
+    const auto rating_predicate = [](int document_id, DocumentStatus status, int rating) {
+        return status == DocumentStatus::ACTUAL && rating >= 2;
+    };
+    const auto id_predicate = [](int document_id, DocumentStatus status, int rating) {
+        return document_id % 1'000 == 0;
+    };
+    const auto run = [&](const string& mark, const auto& filter) {
+        LOG_DURATION(mark);
+        size_t document_count = 0;
+        for (const string& query : queries) {
+            document_count += search_server.FindTopDocuments(query, filter).size();
+        }
+        cout << mark << " documents: "s << document_count << endl;
+    };
+    run("Rating predicate"s, rating_predicate);
+    run("Rating DocumentFilter"s, rating_filter);
+    run("Id predicate"s, id_predicate);
+    run("Id DocumentFilter"s, id_filter);
+}
+
+// Replays a skewed workload where 40% of requests repeat a few popular queries.
+void BenchmarkQueryCache(mt19937& generator, SearchServer& search_server, const vector<string>& queries) {
+    vector<string> workload;
+    uniform_int_distribution<size_t> popular_distribution(0, 9);
+    uniform_int_distribution<size_t> query_distribution(0, queries.size() - 1);
+    bernoulli_distribution is_popular(0.4);
+    for (int i = 0; i < 3'000; ++i) {
+        workload.push_back(queries[is_popular(generator) ? popular_distribution(generator) : query_distribution(generator)]);
+    }
+    BenchmarkQueriesLoop("Skewed queries without cache"s, search_server, workload);
+    search_server.EnableQueryCache(1'000);
+    BenchmarkQueriesLoop("Skewed queries with cache"s, search_server, workload);
+    const QueryCacheStats stats = search_server.GetQueryCacheStats();
+    cout << "Query cache: "s << stats.hit_count << " hits, "s << stats.miss_count << " misses"s << endl;
+    search_server.EnableQueryCache(0);
+}
+
+// Compares adding documents one by one with adding them in a batch.
+void BenchmarkAddDocuments(mt19937& generator, const vector<string>& dictionary, const vector<string>& queries) {
+    vector<NewDocument> documents;
+    vector<string> texts;
+    for (int i = 0; i < 100'000; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, 20));
+    }
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
+        documents.push_back({i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+    SearchServer search_server(dictionary[0]);
+    {
+        LOG_DURATION("AddDocument loop"s);
+        for (const NewDocument& document : documents) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    }
+    SearchServer batch_server(dictionary[0]);
+    {
+        LOG_DURATION("AddDocuments batch"s);
+        batch_server.AddDocuments(documents);
+    }
+    cout << "AddDocuments first query results: loop "s << search_server.FindTopDocuments(queries[0]).size()
+         << ", batch "s << batch_server.FindTopDocuments(queries[0]).size() << endl;
+}
+
+// Compares ingesting a file of records with reading it line by line and adding
+// documents one by one.
+void BenchmarkIngest(mt19937& generator, const vector<string>& dictionary, const vector<string>& queries) {
+    const string path = (filesystem::temp_directory_path() / "search_server_benchmark_ingest.tsv"s).string();
+    {
+        ofstream output(path, ios::binary);
+        for (int i = 0; i < 100'000; ++i) {
+            output << i << "\tACTUAL\t1 2 3\t"s << GenerateQuery(generator, dictionary, 20) << '\n';
+        }
+    }
+    SearchServer search_server(dictionary[0]);
+    {
+        LOG_DURATION("Ingest with AddDocument loop"s);
+        ifstream input(path, ios::binary);
+        string line;
+        while (getline(input, line)) {
+            const size_t text_begin = line.find('\t', line.find('\t', line.find('\t') + 1) + 1) + 1;
+            search_server.AddDocument(stoi(line), line.substr(text_begin), DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+    }
+    SearchServer ingested_server(dictionary[0]);
+    const IngestStats stats = IngestDocuments(ingested_server, path);
+    filesystem::remove(path);
+    cout << "IngestDocuments: "s << stats.seconds * 1'000 << " ms, "s << stats.GetMegabytesPerSecond() << " MB/s"s << endl;
+    cout << "Ingest first query results: loop "s << search_server.FindTopDocuments(queries[0]).size()
+         << ", ingest "s << ingested_server.FindTopDocuments(queries[0]).size() << endl;
+}
+
+// Measures query latency of a concurrent server while it's idle and while another
+// thread adds documents and publishes a new generation every 1000 documents.
+void BenchmarkConcurrentSearchServer(mt19937& generator, const vector<string>& dictionary, const vector<string>& queries) {
+    vector<string> texts;
+    for (int i = 0; i < 70'000; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, 20));
+    }
+    SearchServer initial_server(dictionary[0]);
+    for (int i = 0; i < 50'000; ++i) {
+        initial_server.AddDocument(i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    ConcurrentSearchServer search_server(move(initial_server));
+    const auto measure_latency = [&](const string& mark, const atomic<bool>& is_running) {
+        vector<double> latencies;
+        for (size_t i = 0; is_running; ++i) {
+            const auto start = chrono::steady_clock::now();
+            (void) search_server.FindTopDocuments(queries[i % queries.size()]);
+            latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+        }
+        // The writer may finish before a single query does.
+        if (latencies.empty()) {
+            cout << "Concurrent queries "s << mark << ": no queries completed"s << endl;
+            return;
+        }
+        sort(latencies.begin(), latencies.end());
+        cout << "Concurrent queries "s << mark << ": "s << latencies.size() << " queries, p50 "s
+             << latencies[latencies.size() / 2] << " us, p99 "s << latencies[latencies.size() * 99 / 100] << " us"s << endl;
+    };
+    atomic<bool> is_running = true;
+    thread timer([&is_running]() {
+        this_thread::sleep_for(chrono::seconds(2));
+        is_running = false;
+    });
+    measure_latency("idle"s, is_running);
+    timer.join();
+
+    is_running = true;
+    thread writer([&]() {
+        LOG_DURATION("Concurrent ingest of 20000 documents"s);
+        for (int i = 50'000; i < 70'000; ++i) {
+            search_server.AddDocument(i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3});
+            if (i % 1'000 == 999) {
+                search_server.Publish();
+            }
+        }
+        is_running = false;
+    });
+    measure_latency("during ingest"s, is_running);
+    writer.join();
+}
+
+size_t GetResidentMemory() {
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    ifstream("/proc/self/statm"s) >> total_pages >> resident_pages;
+    return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+// Simulates a long-running server which keeps replacing its oldest documents
+// and reports resident memory after every round, with the index on the global
+// heap and in a pool resource.
+void BenchmarkMemoryFragmentation(mt19937& generator, const vector<string>& dictionary, const vector<string>& queries) {
+    vector<string> texts;
+    for (int i = 0; i < 20'000; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, 20));
+    }
+    const auto run_rounds = [&](const string& mark, pmr::memory_resource* memory_resource) {
+        // Free memory left by previous benchmarks is returned to the system first.
+        malloc_trim(0);
+        SearchServer search_server(dictionary[0], memory_resource);
+        int next_id = 0;
+        string report;
+        double total_relevance = 0;
+        {
+            LOG_DURATION("Fragmentation rounds "s + mark);
+            for (int round = 0; round < 8; ++round) {
+                for (int i = 0; i < 10'000; ++i, ++next_id) {
+                    search_server.AddDocument(next_id, texts[next_id % texts.size()], DocumentStatus::ACTUAL, {1});
+                    if (next_id >= 20'000) {
+                        search_server.RemoveDocument(next_id - 20'000);
+                    }
+                }
+                for (const string& query : queries) {
+                    for (const Document& document : search_server.FindTopDocuments(query)) {
+                        total_relevance += document.relevance;
+                    }
+                }
+                report += ' ' + to_string(GetResidentMemory() >> 20);
+            }
+        }
+        cout << "Resident memory by round, MiB, "s << mark << ":"s << report
+             << ", total relevance "s << total_relevance << endl;
+    };
+    run_rounds("global heap"s, pmr::get_default_resource());
+    {
+        pmr::synchronized_pool_resource pool;
+        run_rounds("pool resource"s, &pool);
+    }
+}
+
+// Indexes and searches the same documents with different numbers of shards.
+void BenchmarkShardedSearchServer(mt19937& generator, const vector<string>& dictionary, const vector<string>& queries) {
+    vector<string> texts;
+    for (int i = 0; i < 100'000; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, 20));
+    }
+    vector<NewDocument> documents;
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
+        documents.push_back({i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+    for (const size_t shard_count : {1u, 4u}) {
+        const string mark = to_string(shard_count) + (shard_count == 1 ? " shard"s : " shards"s);
+        ShardedSearchServer search_server(dictionary[0], shard_count);
+        {
+            LOG_DURATION("Sharded AddDocuments "s + mark);
+            search_server.AddDocuments(documents);
+        }
+        double total_relevance = 0;
+        {
+            LOG_DURATION("Sharded FindTopDocuments "s + mark);
+            for (const string& query : queries) {
+                for (const auto& document : search_server.FindTopDocuments(query)) {
+                    total_relevance += document.relevance;
+                }
+            }
+        }
+        cout << "Sharded FindTopDocuments "s << mark << " total relevance: "s << total_relevance << endl;
+    }
+}
+
+// Compares the startup of a server replaying AddDocument with loading its snapshot.
+void BenchmarkColdStart(mt19937& generator, const vector<string>& dictionary, const vector<string>& queries) {
+    vector<string> texts;
+    for (int i = 0; i < 100'000; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, 20));
+    }
+    const string path = (filesystem::temp_directory_path() / "search_server_benchmark.snapshot"s).string();
+    double replay_relevance = 0;
+    SearchServer search_server(dictionary[0]);
+    {
+        LOG_DURATION("Cold start with AddDocument replay"s);
+        for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
+            search_server.AddDocument(i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        for (const auto& document : search_server.FindTopDocuments(queries[0])) {
+            replay_relevance += document.relevance;
+        }
+    }
+    search_server.SaveSnapshot(path);
+    double snapshot_relevance = 0;
+    {
+        LOG_DURATION("Cold start with LoadSnapshot"s);
+        const SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+        for (const auto& document : loaded_server.FindTopDocuments(queries[0])) {
+            snapshot_relevance += document.relevance;
+        }
+    }
+    filesystem::remove(path);
+    cout << "Cold start first query relevance: replay "s << replay_relevance << ", snapshot "s << snapshot_relevance << endl;
+}
+
+void RunBenchmarks() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    auto search_server = GenerateSearchServer(generator, dictionary, 100'000, 20);
+    const auto queries = GenerateQueries(generator, dictionary, 100, 10);
+    PrintIndexStats(search_server);
+
+    BenchmarkQueryAllocations("Long queries"s, search_server, queries);
+    BenchmarkFindTopDocuments("FindTopDocuments seq"s, search_server, queries, execution::seq);
+    BenchmarkFindTopDocuments("FindTopDocuments par"s, search_server, queries, execution::par);
+
+    const auto batch_queries = GenerateQueries(generator, dictionary, 1'000, 3);
+    BenchmarkQueriesLoop("Queries loop"s, search_server, batch_queries);
+    BenchmarkRequestQueue("RequestQueue"s, search_server, batch_queries);
+    BenchmarkProcessQueriesJoined("ProcessQueriesJoined"s, search_server, batch_queries);
+    BenchmarkQueryCache(generator, search_server, batch_queries);
+    BenchmarkCompressedPostings(search_server, queries);
+    BenchmarkDocumentFilter(search_server, batch_queries);
+
+    BenchmarkColdStart(generator, dictionary, queries);
+    BenchmarkAddDocuments(generator, dictionary, queries);
+    BenchmarkIngest(generator, dictionary, queries);
+    BenchmarkShardedSearchServer(generator, dictionary, queries);
+    BenchmarkConcurrentSearchServer(generator, dictionary, queries);
+    BenchmarkMemoryFragmentation(generator, dictionary, queries);
+    BenchmarkRelevanceKernels(generator);
+}
+
+int main() {
+    RunBenchmarks();
+    return 0;
+}
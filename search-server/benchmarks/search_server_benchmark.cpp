@@ -0,0 +1,229 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "corpus_generator.h"
+#include "query_scratch.h"
+#include "search_server.h"
+
+using namespace std;
+
+// Regression suite. Results are written as JSON with
+//     search_server_benchmark --benchmark_format=json --benchmark_out=results.json
+// The corpus is set up with flags of its own:
+//     --documents=N       documents in the corpus, 100000 by default
+//     --vocabulary=N      words in the dictionary, 10000 by default
+//     --skew=S            Zipf exponent of word frequencies, 1.0 by default, 0 for uniform
+//     --document_words=N  words per document, 20 by default
+
+struct CorpusOptions {
+    int document_count = 100'000;
+    int vocabulary_size = 10'000;
+    double skew = 1.0;
+    int document_word_count = 20;
+};
+
+struct Corpus {
+    vector<string> dictionary;
+    vector<string> texts;
+    SearchServer server;
+    // Queries of frequent words match much of the corpus, queries of rare words
+    // a few documents, minus-heavy queries exclude many of the matched ones.
+    // Long queries are typical for highlighting of results.
+    vector<string> narrow_queries;
+    vector<string> broad_queries;
+    vector<string> minus_heavy_queries;
+    vector<string> long_queries;
+};
+
+// The benchmark measures query parsing alone, which is private to the server.
+class ParseQueryBenchmark {
+public:
+    static size_t ParseQuery(const SearchServer& server, string_view raw_query) {
+        QueryScratch scratch;
+        const SearchServer::Query query = server.ParseQuery(raw_query, scratch.GetResource());
+        return query.plus_words.size() + query.minus_words.size();
+    }
+};
+
+const int QUERY_COUNT = 1'000;
+
+string GenerateRankedQuery(mt19937& generator, const ZipfWordGenerator& words, int plus_word_count, int first_rank,
+                           int last_rank, int minus_word_count = 0) {
+    string query;
+    for (int i = 0; i < plus_word_count + minus_word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (i >= plus_word_count) {
+            query.push_back('-');
+        }
+        query += words.GetRanked(generator, first_rank, last_rank);
+    }
+    return query;
+}
+
+const Corpus& BuildCorpus(const CorpusOptions& options) {
+    static Corpus corpus;
+    mt19937 generator;
+    corpus.dictionary = GenerateDictionary(generator, options.vocabulary_size, 10);
+    // Dictionary words are sorted, ranks are shuffled so that frequency doesn't depend on spelling.
+    shuffle(corpus.dictionary.begin(), corpus.dictionary.end(), generator);
+    ZipfWordGenerator words(corpus.dictionary, options.skew);
+    const int word_count = words.GetWordCount();
+
+    vector<NewDocument> documents;
+    corpus.texts.reserve(options.document_count);
+    documents.reserve(options.document_count);
+    for (int i = 0; i < options.document_count; ++i) {
+        corpus.texts.push_back(GenerateText(generator, words, options.document_word_count));
+        documents.push_back({i, corpus.texts.back(), DocumentStatus::ACTUAL, {i % 10}});
+    }
+    corpus.server.AddDocuments(documents);
+
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        corpus.narrow_queries.push_back(GenerateRankedQuery(generator, words, 3, word_count / 2, word_count));
+        corpus.broad_queries.push_back(GenerateRankedQuery(generator, words, 5, 0, min(word_count, 20)));
+        corpus.minus_heavy_queries.push_back(GenerateRankedQuery(generator, words, 3, 0, min(word_count, 100), 6));
+        corpus.long_queries.push_back(GenerateRankedQuery(generator, words, 100, 0, word_count, 4));
+    }
+    return corpus;
+}
+
+void BM_AddDocument(benchmark::State& state, const Corpus& corpus) {
+    SearchServer server;
+    size_t text_index = 0;
+    for (auto _ : state) {
+        if (text_index == corpus.texts.size()) {
+            state.PauseTiming();
+            server = SearchServer();
+            text_index = 0;
+            state.ResumeTiming();
+        }
+        server.AddDocument(text_index, corpus.texts[text_index], DocumentStatus::ACTUAL, {1, 2, 3});
+        ++text_index;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void RunFindTopDocuments(benchmark::State& state, const SearchServer& server, const vector<string>& queries) {
+    const QueryEvaluationStats initial_stats = server.GetQueryEvaluationStats();
+    size_t query_index = 0;
+    size_t result_count = 0;
+    for (auto _ : state) {
+        const vector<Document> documents = server.FindTopDocuments(queries[query_index]);
+        result_count += documents.size();
+        benchmark::DoNotOptimize(documents.data());
+        query_index = (query_index + 1) % queries.size();
+    }
+    const QueryEvaluationStats stats = server.GetQueryEvaluationStats();
+    state.SetItemsProcessed(state.iterations());
+    state.counters["results"] = benchmark::Counter(result_count, benchmark::Counter::kAvgIterations);
+    state.counters["postings_scored"] = benchmark::Counter(stats.scored_posting_count - initial_stats.scored_posting_count,
+                                                           benchmark::Counter::kAvgIterations);
+}
+
+void BM_FindTopDocuments(benchmark::State& state, const Corpus& corpus, const vector<string>* queries) {
+    RunFindTopDocuments(state, corpus.server, *queries);
+}
+
+void BM_FindTopDocumentsWith(benchmark::State& state, const Corpus& corpus, const vector<string>* queries,
+                             QueryEvaluation evaluation) {
+    SearchServer server = corpus.server;
+    server.SetQueryEvaluation(evaluation);
+    RunFindTopDocuments(state, server, *queries);
+}
+
+template<typename ExecutionPolicy>
+void BM_MatchDocument(benchmark::State& state, const Corpus& corpus, const vector<string>* queries, ExecutionPolicy policy) {
+    const int document_count = corpus.server.GetDocumentCount();
+    size_t query_index = 0;
+    int document_id = 0;
+    for (auto _ : state) {
+        auto result = corpus.server.MatchDocument(policy, (*queries)[query_index], document_id);
+        benchmark::DoNotOptimize(result);
+        query_index = (query_index + 1) % queries->size();
+        document_id = (document_id + 7'919) % document_count;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ParseQuery(benchmark::State& state, const Corpus& corpus) {
+    size_t query_index = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ParseQueryBenchmark::ParseQuery(corpus.server, corpus.minus_heavy_queries[query_index]));
+        query_index = (query_index + 1) % corpus.minus_heavy_queries.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Takes the corpus flags out of the arguments, Google Benchmark rejects unknown ones.
+CorpusOptions ParseCorpusOptions(int& argc, char** argv) {
+    CorpusOptions options;
+    int kept_count = 1;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        const auto value_of = [arg](string_view flag) -> const char* {
+            return arg.substr(0, flag.size()) == flag ? arg.data() + flag.size() : nullptr;
+        };
+        if (const char* value = value_of("--documents="sv)) {
+            options.document_count = atoi(value);
+        } else if (const char* value = value_of("--vocabulary="sv)) {
+            options.vocabulary_size = atoi(value);
+        } else if (const char* value = value_of("--skew="sv)) {
+            options.skew = atof(value);
+        } else if (const char* value = value_of("--document_words="sv)) {
+            options.document_word_count = atoi(value);
+        } else {
+            argv[kept_count++] = argv[i];
+        }
+    }
+    argc = kept_count;
+    return options;
+}
+
+int main(int argc, char** argv) {
+    const CorpusOptions options = ParseCorpusOptions(argc, argv);
+    if (options.document_count <= 0 || options.vocabulary_size <= 0 || options.skew < 0 || options.document_word_count <= 0) {
+        cerr << "Corpus sizes must be positive and skew non-negative"s << endl;
+        return 1;
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    const Corpus& corpus = BuildCorpus(options);
+    benchmark::AddCustomContext("documents", to_string(options.document_count));
+    benchmark::AddCustomContext("vocabulary", to_string(options.vocabulary_size));
+    benchmark::AddCustomContext("skew", to_string(options.skew));
+    benchmark::AddCustomContext("document_words", to_string(options.document_word_count));
+
+    benchmark::RegisterBenchmark("AddDocument", BM_AddDocument, corpus);
+    benchmark::RegisterBenchmark("FindTopDocuments/narrow", BM_FindTopDocuments, corpus, &corpus.narrow_queries);
+    benchmark::RegisterBenchmark("FindTopDocuments/broad", BM_FindTopDocuments, corpus, &corpus.broad_queries);
+    benchmark::RegisterBenchmark("FindTopDocuments/minus_heavy", BM_FindTopDocuments, corpus, &corpus.minus_heavy_queries);
+    for (const auto& [name, evaluation] : {pair("daat"s, QueryEvaluation::DOCUMENT_AT_A_TIME),
+                                           pair("wand"s, QueryEvaluation::WAND)}) {
+        benchmark::RegisterBenchmark(("FindTopDocuments/narrow/"s + name).c_str(), BM_FindTopDocumentsWith, corpus,
+                                     &corpus.narrow_queries, evaluation);
+        benchmark::RegisterBenchmark(("FindTopDocuments/broad/"s + name).c_str(), BM_FindTopDocumentsWith, corpus,
+                                     &corpus.broad_queries, evaluation);
+    }
+    benchmark::RegisterBenchmark("MatchDocument/narrow", BM_MatchDocument<execution::sequenced_policy>, corpus,
+                                 &corpus.narrow_queries, execution::seq);
+    benchmark::RegisterBenchmark("MatchDocument/long/seq", BM_MatchDocument<execution::sequenced_policy>, corpus,
+                                 &corpus.long_queries, execution::seq);
+    benchmark::RegisterBenchmark("MatchDocument/long/par", BM_MatchDocument<execution::parallel_policy>, corpus,
+                                 &corpus.long_queries, execution::par);
+    benchmark::RegisterBenchmark("ParseQuery", BM_ParseQuery, corpus);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+// Lets readers search while documents are added or removed. Readers query the
+// published index generation, which never changes. Writers change the next
+// generation, invisible to readers until Publish swaps it in atomically.
+// Two copies of the index take turns: after a swap the previous generation is
+// brought up to date with the published one once its last reader is gone,
+// and becomes the next generation.
+class ConcurrentSearchServer {
+public:
+    explicit ConcurrentSearchServer(SearchServer search_server)
+        : next_(make_shared<SearchServer>(search_server)),
+          current_(make_shared<SearchServer>(move(search_server))),
+          current_release_(make_shared<GenerationRelease>()),
+          published_(MakePublished()) {}
+
+    // The generation stays alive and unchanged while the pointer is held.
+    shared_ptr<const SearchServer> GetPublished() const {
+        return atomic_load(&published_);
+    }
+
+    template<typename... Args>
+    vector<Document> FindTopDocuments(Args&&... args) const {
+        return GetPublished()->FindTopDocuments(forward<Args>(args)...);
+    }
+
+    // Both generations keep every word they've indexed, so matched words stay valid
+    // while the server lives.
+    tuple<vector<string_view>, DocumentStatus> MatchDocument(string_view raw_query, int document_id) const {
+        return GetPublished()->MatchDocument(raw_query, document_id);
+    }
+
+    int GetDocumentCount() const {
+        return GetPublished()->GetDocumentCount();
+    }
+
+    void AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+        lock_guard guard(writer_mutex_);
+        next_->AddDocument(document_id, document, status, ratings);
+        PendingChange& change = pending_changes_.emplace_back();
+        change.texts.emplace_back(document);
+        change.documents.push_back({document_id, change.texts.back(), status, ratings});
+    }
+
+    void AddDocuments(const vector<NewDocument>& documents) {
+        lock_guard guard(writer_mutex_);
+        const int document_count = next_->GetDocumentCount();
+        // Documents added before a rejected one are kept, as by SearchServer itself.
+        // They are replayed as one batch, which counts as one change of the index.
+        const auto record_added_documents = [&]() {
+            const size_t added_count = next_->GetDocumentCount() - document_count;
+            if (added_count == 0) {
+                return;
+            }
+            PendingChange& change = pending_changes_.emplace_back();
+            change.is_batch = true;
+            change.texts.reserve(added_count);
+            for (size_t i = 0; i < added_count; ++i) {
+                const NewDocument& document = documents[i];
+                change.texts.emplace_back(document.text);
+                change.documents.push_back({document.id, change.texts.back(), document.status, document.ratings});
+            }
+        };
+        try {
+            next_->AddDocuments(documents);
+        } catch (...) {
+            record_added_documents();
+            throw;
+        }
+        record_added_documents();
+    }
+
+    void RemoveDocument(int document_id) {
+        lock_guard guard(writer_mutex_);
+        next_->RemoveDocument(document_id);
+        PendingChange& change = pending_changes_.emplace_back();
+        change.is_removal = true;
+        change.removed_document_id = document_id;
+    }
+
+    // Makes the changes visible to readers. Blocks, without spinning, until the readers
+    // of the replaced generation release it; other writers wait on writer_mutex_ meanwhile,
+    // so a thread must not hold a generation while publishing.
+    void Publish() {
+        lock_guard guard(writer_mutex_);
+        shared_ptr<SearchServer> previous = move(current_);
+        const shared_ptr<GenerationRelease> previous_release = move(current_release_);
+        current_ = next_;
+        current_release_ = make_shared<GenerationRelease>();
+        atomic_store(&published_, MakePublished());
+        // New readers get the new generation, only those already holding the previous one remain.
+        {
+            unique_lock lock(previous_release->state_mutex);
+            previous_release->released.wait(lock, [&]() { return previous_release->is_released; });
+        }
+        for (const PendingChange& change : pending_changes_) {
+            if (change.is_removal) {
+                previous->RemoveDocument(change.removed_document_id);
+            } else if (change.is_batch) {
+                previous->AddDocuments(change.documents);
+            } else {
+                const NewDocument& document = change.documents.front();
+                previous->AddDocument(document.id, document.text, document.status, document.ratings);
+            }
+        }
+        pending_changes_.clear();
+        next_ = move(previous);
+    }
+
+private:
+    // Changes applied to the next generation but not yet to the published one,
+    // replayed the same way so that both generations count the same changes.
+    struct PendingChange {
+        bool is_removal = false;
+        bool is_batch = false;
+        int removed_document_id = 0;
+        // Added documents refer to their texts here, moving the vector leaves the strings in place.
+        vector<string> texts;
+        vector<NewDocument> documents;
+    };
+
+    // Signalled when the last reader of a published generation lets it go.
+    struct GenerationRelease {
+        mutex state_mutex;
+        condition_variable released;
+        bool is_released = false;
+    };
+
+    // The readers' pointers share one control block per publication, its deleter
+    // runs once all of them are gone. It keeps the generation alive, not the server.
+    shared_ptr<const SearchServer> MakePublished() const {
+        return shared_ptr<const SearchServer>(
+            current_.get(), [generation = current_, release = current_release_](const SearchServer*) {
+                lock_guard guard(release->state_mutex);
+                release->is_released = true;
+                release->released.notify_all();
+            });
+    }
+
+    mutex writer_mutex_;
+    shared_ptr<SearchServer> next_;
+    // The published generation, current_ is the writer's handle to change it once it's replaced.
+    shared_ptr<SearchServer> current_;
+    shared_ptr<GenerationRelease> current_release_;
+    shared_ptr<const SearchServer> published_;
+    vector<PendingChange> pending_changes_;
+};
@@ -0,0 +1,40 @@
+#include "document.h"
+
+#include <cmath>
+#include <string>
+
+using namespace std;
+
+bool CompareDocumentsByRelevance(const Document& lhs, const Document& rhs) {
+    if (abs(lhs.relevance - rhs.relevance) < EPSILON) {
+        return lhs.rating > rhs.rating;
+    } else {
+        return lhs.relevance > rhs.relevance;
+    }
+}
+
+ostream& operator<<(ostream& o, const DocumentStatus& status) {
+    switch (status) {
+        case DocumentStatus::ACTUAL:
+            o << "ACTUAL"s;
+            break;
+        case DocumentStatus::IRRELEVANT:
+            o << "IRRELEVANT"s;
+            break;
+        case DocumentStatus::BANNED:
+            o << "BANNED"s;
+            break;
+        case DocumentStatus::REMOVED:
+            o << "REMOVED"s;
+            break;
+    }
+    return o;
+}
+
+ostream& operator<<(ostream& o, const Document& document) {
+    o << "{ "s
+      << "document_id = "s << document.id << ", "s
+      << "relevance = "s << document.relevance << ", "s
+      << "rating = "s << document.rating << " }"s;
+    return o;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <optional>
+#include <ostream>
+#include <vector>
+#include <string_view>
+
+using namespace std;
+
+const double EPSILON = 1e-6;
+
+struct Document {
+    int id;
+    double relevance;
+    int rating;
+
+    Document() {
+        id = 0;
+        relevance = 0.0;
+        rating = 0;
+    }
+
+    Document(int id_, double relevance_, int rating_) {
+        id = id_;
+        relevance = relevance_;
+        rating = rating_;
+    }
+};
+
+// Orders documents by descending relevance, documents of equal relevance
+// (within EPSILON) by descending rating.
+bool CompareDocumentsByRelevance(const Document& lhs, const Document& rhs);
+
+enum class DocumentStatus {
+    ACTUAL,
+    IRRELEVANT,
+    BANNED,
+    REMOVED,
+};
+
+ostream& operator<<(ostream& o, const DocumentStatus& status);
+
+// Conditions on documents that the index checks on its own columns before
+// documents are scored. Unset conditions hold for every document,
+// rating bounds are inclusive.
+struct DocumentFilter {
+    optional<DocumentStatus> status;
+    optional<int> min_rating;
+    optional<int> max_rating;
+    optional<vector<int>> document_ids;
+};
+
+// Arguments of AddDocument for adding documents in batches.
+struct NewDocument {
+    int id;
+    string_view text;
+    DocumentStatus status;
+    vector<int> ratings;
+};
+
+ostream& operator<<(ostream& o, const Document& document);
@@ -0,0 +1,106 @@
+#include "document_columns.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+DocumentColumns::DocumentColumns(pmr::memory_resource* memory_resource)
+    : status_bits_{pmr::vector<uint64_t>(memory_resource), pmr::vector<uint64_t>(memory_resource),
+                   pmr::vector<uint64_t>(memory_resource), pmr::vector<uint64_t>(memory_resource)},
+      rating_order_(memory_resource) {}
+
+DocumentColumns::DocumentColumns(const DocumentColumns& other, pmr::memory_resource* memory_resource)
+    : DocumentColumns(memory_resource) {
+    for (size_t status = 0; status < STATUS_COUNT; ++status) {
+        status_bits_[status] = other.status_bits_[status];
+    }
+    lock_guard guard(*other.rating_order_mutex_);
+    rating_order_ = other.rating_order_;
+    sorted_rating_count_ = other.sorted_rating_count_;
+}
+
+void DocumentColumns::Add(int dense_id, DocumentStatus status, int rating) {
+    const size_t word_count = dense_id / 64 + 1;
+    for (pmr::vector<uint64_t>& bits : status_bits_) {
+        bits.resize(word_count);
+    }
+    status_bits_[static_cast<size_t>(status)][dense_id / 64] |= uint64_t{1} << (dense_id % 64);
+    rating_order_.emplace_back(rating, dense_id);
+}
+
+void DocumentColumns::Remove(int dense_id, DocumentStatus status) {
+    status_bits_[static_cast<size_t>(status)][dense_id / 64] &= ~(uint64_t{1} << (dense_id % 64));
+}
+
+DocumentSelection DocumentColumns::Select(const DocumentFilter& filter, const pmr::vector<int>& listed_dense_ids,
+                                          pmr::memory_resource* memory_resource) const {
+    const size_t word_count = status_bits_.front().size();
+    const bool has_rating = filter.min_rating.has_value() || filter.max_rating.has_value();
+    if (filter.status && !has_rating && !filter.document_ids) {
+        return {status_bits_[static_cast<size_t>(*filter.status)].data(), word_count, {}};
+    }
+
+    DocumentSelection selection{nullptr, word_count, pmr::vector<uint64_t>(memory_resource)};
+    pmr::vector<uint64_t>& bits = selection.storage;
+    if (filter.status) {
+        bits = status_bits_[static_cast<size_t>(*filter.status)];
+    } else {
+        bits.resize(word_count);
+        for (size_t w = 0; w < word_count; ++w) {
+            bits[w] = status_bits_[0][w] | status_bits_[1][w] | status_bits_[2][w] | status_bits_[3][w];
+        }
+    }
+    pmr::vector<uint64_t> condition_bits(word_count, memory_resource);
+    const auto apply_condition = [&]() {
+        for (size_t w = 0; w < word_count; ++w) {
+            bits[w] &= condition_bits[w];
+            condition_bits[w] = 0;
+        }
+    };
+    if (has_rating) {
+        const int min_rating = filter.min_rating.value_or(numeric_limits<int>::min());
+        const int max_rating = filter.max_rating.value_or(numeric_limits<int>::max());
+        const pmr::vector<pair<int, int>>& rating_order = GetRatingOrder();
+        if (min_rating <= max_rating) {
+            const auto first = lower_bound(rating_order.begin(), rating_order.end(),
+                                           pair(min_rating, numeric_limits<int>::min()));
+            const auto last = upper_bound(first, rating_order.end(), pair(max_rating, numeric_limits<int>::max()));
+            // Wide ranges are selected by clearing the documents outside of them.
+            if (static_cast<size_t>(last - first) * 2 > rating_order.size()) {
+                fill(condition_bits.begin(), condition_bits.end(), ~uint64_t{0});
+                for (const auto& range : {pair(rating_order.begin(), first), pair(last, rating_order.end())}) {
+                    for (auto it = range.first; it != range.second; ++it) {
+                        condition_bits[it->second / 64] &= ~(uint64_t{1} << (it->second % 64));
+                    }
+                }
+            } else {
+                for (auto it = first; it != last; ++it) {
+                    condition_bits[it->second / 64] |= uint64_t{1} << (it->second % 64);
+                }
+            }
+        }
+        apply_condition();
+    }
+    if (filter.document_ids) {
+        for (const int dense_id : listed_dense_ids) {
+            condition_bits[dense_id / 64] |= uint64_t{1} << (dense_id % 64);
+        }
+        apply_condition();
+    }
+    selection.bits = bits.data();
+    return selection;
+}
+
+// Queries run concurrently, the first one to need the column sorts it,
+// after that it isn't changed until the next Add.
+const pmr::vector<pair<int, int>>& DocumentColumns::GetRatingOrder() const {
+    lock_guard guard(*rating_order_mutex_);
+    if (sorted_rating_count_ < rating_order_.size()) {
+        const auto middle = rating_order_.begin() + sorted_rating_count_;
+        sort(middle, rating_order_.end());
+        inplace_merge(rating_order_.begin(), middle, rating_order_.end());
+        sorted_rating_count_ = rating_order_.size();
+    }
+    return rating_order_;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+using namespace std;
+
+// Documents selected by a filter, a bitset over dense ids. Null bits select every
+// document. Bits point either into the columns or into the selection's own storage.
+struct DocumentSelection {
+    const uint64_t* bits = nullptr;
+    size_t word_count = 0;
+    pmr::vector<uint64_t> storage;
+
+    bool Contains(int dense_id) const {
+        return bits == nullptr
+            || (static_cast<size_t>(dense_id / 64) < word_count && (bits[dense_id / 64] >> (dense_id % 64) & 1) != 0);
+    }
+};
+
+// Documents' metadata laid out by dense id for evaluating DocumentFilter:
+// a bitset of documents per status and dense ids sorted by rating.
+// Removed documents are dropped from the status bitsets only, every selection
+// is limited to the documents present in one of them.
+class DocumentColumns {
+public:
+    explicit DocumentColumns(pmr::memory_resource* memory_resource);
+
+    DocumentColumns(const DocumentColumns& other, pmr::memory_resource* memory_resource);
+
+    DocumentColumns(DocumentColumns&&) = default;
+    DocumentColumns& operator=(DocumentColumns&&) = default;
+
+    // Dense ids are added in increasing order.
+    void Add(int dense_id, DocumentStatus status, int rating);
+
+    void Remove(int dense_id, DocumentStatus status);
+
+    // The status condition alone selects the status bitset itself, other conditions
+    // are combined in a bitset allocated from the memory resource. Listed dense ids
+    // are used when the filter has the id condition.
+    DocumentSelection Select(const DocumentFilter& filter, const pmr::vector<int>& listed_dense_ids,
+                             pmr::memory_resource* memory_resource) const;
+
+private:
+    static constexpr size_t STATUS_COUNT = static_cast<size_t>(DocumentStatus::REMOVED) + 1;
+
+    array<pmr::vector<uint64_t>, STATUS_COUNT> status_bits_;
+    // Pairs of rating and dense id. New documents are appended, the column is
+    // sorted by the first search by rating after them.
+    mutable pmr::vector<pair<int, int>> rating_order_;
+    mutable size_t sorted_rating_count_ = 0;
+    mutable unique_ptr<mutex> rating_order_mutex_ = make_unique<mutex>();
+
+    const pmr::vector<pair<int, int>>& GetRatingOrder() const;
+};
@@ -0,0 +1,316 @@
+#include "ingest_documents.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "mapped_file.h"
+#include "string_processing.h"
+
+using namespace std;
+
+namespace {
+
+// Queue of limited capacity between stages of the pipeline. Push waits while
+// the queue is full and Pop while it's empty. After Close pending items are
+// still popped, after Cancel they are dropped; neither accepts new items.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(max<size_t>(capacity, 1)) {}
+
+    bool Push(T item) {
+        unique_lock lock(mutex_);
+        not_full_.wait(lock, [this] {
+            return is_closed_ || items_.size() < capacity_;
+        });
+        if (is_closed_) {
+            return false;
+        }
+        items_.push_back(move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    optional<T> Pop() {
+        unique_lock lock(mutex_);
+        not_empty_.wait(lock, [this] {
+            return is_closed_ || !items_.empty();
+        });
+        if (items_.empty()) {
+            return nullopt;
+        }
+        T item = move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return item;
+    }
+
+    void Close() {
+        lock_guard guard(mutex_);
+        is_closed_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    void Cancel() {
+        lock_guard guard(mutex_);
+        items_.clear();
+        is_closed_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    deque<T> items_;
+    bool is_closed_ = false;
+    mutex mutex_;
+    condition_variable not_full_;
+    condition_variable not_empty_;
+};
+
+// Whole lines of the input. Text points into the storage or into a mapped file.
+struct Chunk {
+    size_t index;
+    unique_ptr<string> storage;
+    string_view text;
+};
+
+// Documents point into the storage of their chunk. Documents before a malformed
+// record are kept along with the error.
+struct ParsedChunk {
+    size_t index;
+    unique_ptr<string> storage;
+    size_t byte_count;
+    vector<NewDocument> documents;
+    exception_ptr error;
+};
+
+int ParseNumber(string_view text) {
+    int value = 0;
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (error != errc() || end != text.data() + text.size()) {
+        throw(invalid_argument("Invalid number in document record: "s + string(text)));
+    }
+    return value;
+}
+
+DocumentStatus ParseStatus(string_view text) {
+    static constexpr pair<string_view, DocumentStatus> STATUSES[] = {
+        {"ACTUAL"sv, DocumentStatus::ACTUAL},
+        {"IRRELEVANT"sv, DocumentStatus::IRRELEVANT},
+        {"BANNED"sv, DocumentStatus::BANNED},
+        {"REMOVED"sv, DocumentStatus::REMOVED},
+    };
+    for (const auto& [name, status] : STATUSES) {
+        if (text == name) {
+            return status;
+        }
+    }
+    throw(invalid_argument("Invalid status in document record: "s + string(text)));
+}
+
+NewDocument ParseRecord(string_view line) {
+    string_view fields[3];
+    for (string_view& field : fields) {
+        const size_t tab = line.find('\t');
+        if (tab == string_view::npos) {
+            throw(invalid_argument("Document record must have id, status, ratings and text separated by tabs"s));
+        }
+        field = line.substr(0, tab);
+        line.remove_prefix(tab + 1);
+    }
+    NewDocument document{ParseNumber(fields[0]), line, ParseStatus(fields[1]), {}};
+    for (const string_view rating : SplitIntoWords(fields[2])) {
+        document.ratings.push_back(ParseNumber(rating));
+    }
+    return document;
+}
+
+ParsedChunk ParseChunk(Chunk chunk) {
+    ParsedChunk parsed{chunk.index, move(chunk.storage), chunk.text.size(), {}, nullptr};
+    string_view text = chunk.text;
+    try {
+        while (!text.empty()) {
+            const size_t line_end = text.find('\n');
+            string_view line = text.substr(0, line_end);
+            text.remove_prefix(line_end == string_view::npos ? text.size() : line_end + 1);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (!line.empty()) {
+                parsed.documents.push_back(ParseRecord(line));
+            }
+        }
+    } catch (...) {
+        parsed.error = current_exception();
+    }
+    return parsed;
+}
+
+// Runs the reader, the parsers and the server stage until next_chunk returns nullopt.
+template <typename ChunkReader>
+IngestStats RunIngestPipeline(SearchServer& search_server, ChunkReader next_chunk, const IngestOptions& options) {
+    const auto start = chrono::steady_clock::now();
+    const size_t worker_count = options.worker_count > 0 ? options.worker_count
+                                                         : max(1u, thread::hardware_concurrency());
+    BoundedQueue<Chunk> chunks(options.queue_capacity);
+    BoundedQueue<ParsedChunk> parsed_chunks(options.queue_capacity);
+
+    exception_ptr reader_error;
+    thread reader([&] {
+        try {
+            while (optional<Chunk> chunk = next_chunk()) {
+                if (!chunks.Push(move(*chunk))) {
+                    break;
+                }
+            }
+        } catch (...) {
+            reader_error = current_exception();
+        }
+        chunks.Close();
+    });
+    // Errors of parsing are passed on with the chunk, others (such as bad_alloc)
+    // stop the workers; the chunk they were on never arrives and ends the ingest.
+    atomic<size_t> running_worker_count = worker_count;
+    vector<exception_ptr> worker_errors(worker_count);
+    vector<thread> workers;
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back([&, i] {
+            try {
+                while (optional<Chunk> chunk = chunks.Pop()) {
+                    if (!parsed_chunks.Push(ParseChunk(move(*chunk)))) {
+                        break;
+                    }
+                }
+            } catch (...) {
+                worker_errors[i] = current_exception();
+                chunks.Cancel();
+            }
+            if (--running_worker_count == 0) {
+                parsed_chunks.Close();
+            }
+        });
+    }
+
+    // Chunks are parsed out of order, they wait here for the preceding ones.
+    IngestStats stats;
+    map<size_t, ParsedChunk> pending_chunks;
+    size_t next_index = 0;
+    exception_ptr error;
+    try {
+        while (optional<ParsedChunk> parsed = parsed_chunks.Pop()) {
+            pending_chunks.emplace(parsed->index, move(*parsed));
+            for (auto it = pending_chunks.find(next_index); it != pending_chunks.end();
+                 it = pending_chunks.find(++next_index)) {
+                const ParsedChunk& chunk = it->second;
+                search_server.AddDocuments(chunk.documents);
+                if (chunk.error) {
+                    rethrow_exception(chunk.error);
+                }
+                stats.document_count += chunk.documents.size();
+                stats.byte_count += chunk.byte_count;
+                pending_chunks.erase(it);
+            }
+        }
+    } catch (...) {
+        error = current_exception();
+    }
+    chunks.Cancel();
+    parsed_chunks.Cancel();
+    reader.join();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    for (const exception_ptr& worker_error : worker_errors) {
+        if (!error) {
+            error = worker_error;
+        }
+    }
+    if (!error) {
+        error = reader_error;
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+}  // namespace
+
+IngestStats IngestDocuments(SearchServer& search_server, istream& input, const IngestOptions& options) {
+    const size_t chunk_size = max<size_t>(options.chunk_size, 1);
+    string carry;
+    size_t index = 0;
+    bool is_input_exhausted = false;
+    // Reads until the chunk has a line end after chunk_size bytes, a longer
+    // line makes a longer chunk. The rest after the last line end is carried over.
+    const auto next_chunk = [&]() -> optional<Chunk> {
+        auto storage = make_unique<string>(move(carry));
+        carry.clear();
+        while (!is_input_exhausted) {
+            const size_t size = storage->size();
+            storage->resize(size + chunk_size);
+            input.read(storage->data() + size, chunk_size);
+            storage->resize(size + input.gcount());
+            if (input.bad()) {
+                throw(runtime_error("Cannot read documents"s));
+            }
+            is_input_exhausted = !input;
+            const size_t line_end = storage->find_last_of('\n');
+            if (!is_input_exhausted && line_end != string::npos && line_end >= size) {
+                carry.assign(*storage, line_end + 1);
+                storage->resize(line_end + 1);
+                break;
+            }
+        }
+        if (storage->empty()) {
+            return nullopt;
+        }
+        const string_view text = *storage;
+        return Chunk{index++, move(storage), text};
+    };
+    return RunIngestPipeline(search_server, next_chunk, options);
+}
+
+IngestStats IngestDocuments(SearchServer& search_server, const string& path, const IngestOptions& options) {
+    if (filesystem::file_size(path) == 0) {
+        return {};
+    }
+    const MappedFile file(path);
+    const char* data = file.GetData();
+    const size_t size = file.GetSize();
+    const size_t chunk_size = max<size_t>(options.chunk_size, 1);
+    size_t offset = 0;
+    size_t index = 0;
+    const auto next_chunk = [&]() -> optional<Chunk> {
+        if (offset >= size) {
+            return nullopt;
+        }
+        size_t end = min(size, offset + chunk_size);
+        if (end < size) {
+            const void* line_end = memchr(data + end - 1, '\n', size - end + 1);
+            end = line_end == nullptr ? size : static_cast<const char*>(line_end) - data + 1;
+        }
+        const string_view text(data + offset, end - offset);
+        offset = end;
+        return Chunk{index++, nullptr, text};
+    };
+    return RunIngestPipeline(search_server, next_chunk, options);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <string>
+
+#include "search_server.h"
+
+using namespace std;
+
+struct IngestOptions {
+    // Input is read and parsed in chunks of about this many bytes, every chunk
+    // is added to the server with a single AddDocuments call.
+    size_t chunk_size = 4 << 20;
+    // Chunks read or parsed ahead of the server, reading blocks while they're full.
+    size_t queue_capacity = 8;
+    // Zero to use a thread per core.
+    size_t worker_count = 0;
+};
+
+struct IngestStats {
+    size_t document_count = 0;
+    size_t byte_count = 0;
+    double seconds = 0;
+
+    double GetMegabytesPerSecond() const {
+        return seconds > 0 ? byte_count / seconds / (1 << 20) : 0;
+    }
+};
+
+// Adds documents of a text stream, one record per line:
+//     id <TAB> status <TAB> ratings separated by spaces <TAB> text
+// Status is one of ACTUAL, IRRELEVANT, BANNED, REMOVED, ratings may be empty
+// and empty lines are skipped. A reader thread cuts the input into chunks at
+// line ends, worker threads parse them, and the calling thread adds the parsed
+// chunks in input order; bounded queues between the stages hold back the
+// reader when the server falls behind. Documents are added as AddDocument
+// would one by one: on a malformed or rejected record the documents before it
+// are added and the error is rethrown.
+IngestStats IngestDocuments(SearchServer& search_server, istream& input, const IngestOptions& options = {});
+
+// Maps the file instead of reading it, records are parsed right from the mapping.
+IngestStats IngestDocuments(SearchServer& search_server, const string& path, const IngestOptions& options = {});
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+class LogDuration {
+public:
+    using Clock = chrono::steady_clock;
+
+    explicit LogDuration(const string& id) : id_(id) {}
+
+    ~LogDuration() {
+        const auto duration = Clock::now() - start_time_;
+        cerr << id_ << ": "s << chrono::duration_cast<chrono::milliseconds>(duration).count() << " ms"s << endl;
+    }
+
+private:
+    const string id_;
+    const Clock::time_point start_time_ = Clock::now();
+};
+
+#define LOG_DURATION_CONCAT_INTERNAL(x, y) x##y
+#define LOG_DURATION_CONCAT(x, y) LOG_DURATION_CONCAT_INTERNAL(x, y)
+#define LOG_DURATION(id) LogDuration LOG_DURATION_CONCAT(log_duration_guard_, __LINE__)(id)
+
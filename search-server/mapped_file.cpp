@@ -0,0 +1,31 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+MappedFile::MappedFile(const string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw(runtime_error("Cannot open file "s + path));
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        throw(runtime_error("Cannot map empty or unreadable file "s + path));
+    }
+    size_ = file_stat.st_size;
+    data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data_ == MAP_FAILED) {
+        throw(runtime_error("Cannot map file "s + path));
+    }
+}
+
+MappedFile::~MappedFile() {
+    munmap(data_, size_);
+}
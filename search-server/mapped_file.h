@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    explicit MappedFile(const string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    const char* GetData() const {
+        return static_cast<const char*>(data_);
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
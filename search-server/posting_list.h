@@ -0,0 +1,640 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+struct Posting {
+    int document_id;
+    double term_freq;
+};
+
+// Postings of a single word sorted by document id. Ids and term frequencies
+// live in two contiguous arrays, so a scan walks memory linearly.
+// The arrays are either owned or borrowed from external read-only memory
+// (a mapped snapshot); borrowed postings are copied before the first change.
+// Postings may also be compressed, then only methods taking inverse word
+// counts of documents, size and Contains are available.
+class PostingList {
+    inline static constexpr size_t COMPRESSION_BLOCK_SIZE = 128;
+
+public:
+    class Iterator {
+    public:
+        using iterator_category = random_access_iterator_tag;
+        using value_type = Posting;
+        using difference_type = ptrdiff_t;
+        using pointer = void;
+        using reference = Posting;
+
+        Iterator() = default;
+
+        Iterator(const int* document_ids, const double* term_freqs, size_t index)
+            : document_ids_(document_ids), term_freqs_(term_freqs), index_(index) {}
+
+        Posting operator*() const {
+            return {document_ids_[index_], term_freqs_[index_]};
+        }
+
+        Posting operator[](difference_type offset) const {
+            return *(*this + offset);
+        }
+
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++index_;
+            return previous;
+        }
+
+        Iterator& operator--() {
+            --index_;
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator previous = *this;
+            --index_;
+            return previous;
+        }
+
+        Iterator& operator+=(difference_type offset) {
+            index_ += offset;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type offset) {
+            index_ -= offset;
+            return *this;
+        }
+
+        Iterator operator+(difference_type offset) const {
+            return Iterator(*this) += offset;
+        }
+
+        friend Iterator operator+(difference_type offset, const Iterator& it) {
+            return it + offset;
+        }
+
+        Iterator operator-(difference_type offset) const {
+            return Iterator(*this) -= offset;
+        }
+
+        difference_type operator-(const Iterator& other) const {
+            return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return index_ != other.index_;
+        }
+
+        bool operator<(const Iterator& other) const {
+            return index_ < other.index_;
+        }
+
+        bool operator>(const Iterator& other) const {
+            return index_ > other.index_;
+        }
+
+        bool operator<=(const Iterator& other) const {
+            return index_ <= other.index_;
+        }
+
+        bool operator>=(const Iterator& other) const {
+            return index_ >= other.index_;
+        }
+
+    private:
+        const int* document_ids_ = nullptr;
+        const double* term_freqs_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    // Walks postings in increasing id order in any representation. Compressed
+    // postings are decoded one block at a time into the cursor, and SkipTo jumps
+    // over whole blocks by their first ids, so a cursor takes constant memory.
+    // The cursor refers to the list and the inverse word counts, which must outlive it.
+    class Cursor {
+    public:
+        Cursor(const PostingList& postings, const double* inverse_word_counts)
+            : postings_(&postings), inverse_word_counts_(inverse_word_counts),
+              document_ids_(postings.GetDocumentIds()), term_freqs_(postings.GetTermFreqs()),
+              size_(postings.size()), is_compressed_(postings.IsCompressed()) {
+            if (is_compressed_) {
+                LoadBlock(0);
+            }
+        }
+
+        bool IsAtEnd() const {
+            return index_ >= size_;
+        }
+
+        // Past the end the id is greater than any document's.
+        int GetDocumentId() const {
+            if (IsAtEnd()) {
+                return numeric_limits<int>::max();
+            }
+            return is_compressed_ ? block_document_ids_[index_ % COMPRESSION_BLOCK_SIZE] : document_ids_[index_];
+        }
+
+        double GetTermFreq() const {
+            return is_compressed_ ? block_term_freqs_[index_ % COMPRESSION_BLOCK_SIZE] : term_freqs_[index_];
+        }
+
+        void Next() {
+            ++index_;
+            if (is_compressed_ && index_ % COMPRESSION_BLOCK_SIZE == 0) {
+                LoadBlock(index_ / COMPRESSION_BLOCK_SIZE);
+            }
+        }
+
+        // Moves to the first posting with id not less than the given one. Ids of
+        // uncompressed postings are searched with exponentially growing steps.
+        void SkipTo(int document_id) {
+            if (GetDocumentId() >= document_id) {
+                return;
+            }
+            if (!is_compressed_) {
+                size_t step = 1;
+                while (index_ + step < size_ && document_ids_[index_ + step] < document_id) {
+                    step *= 2;
+                }
+                index_ = lower_bound(document_ids_ + index_ + step / 2, document_ids_ + min(index_ + step, size_),
+                                     document_id) - document_ids_;
+                return;
+            }
+            const size_t block = postings_->FindBlock(document_id);
+            if (block > index_ / COMPRESSION_BLOCK_SIZE) {
+                index_ = block * COMPRESSION_BLOCK_SIZE;
+                LoadBlock(block);
+            }
+            while (GetDocumentId() < document_id) {
+                Next();
+            }
+        }
+
+    private:
+        const PostingList* postings_;
+        const double* inverse_word_counts_;
+        // Arrays of uncompressed postings.
+        const int* document_ids_;
+        const double* term_freqs_;
+        size_t size_;
+        bool is_compressed_;
+        size_t index_ = 0;
+        array<int, COMPRESSION_BLOCK_SIZE> block_document_ids_;
+        array<double, COMPRESSION_BLOCK_SIZE> block_term_freqs_;
+
+        void LoadBlock(size_t block) {
+            size_t count = 0;
+            postings_->DecodeFromBlock(block, [this, &count](int document_id, uint32_t term_count) {
+                block_document_ids_[count] = document_id;
+                block_term_freqs_[count] = term_count * inverse_word_counts_[document_id];
+                return ++count < COMPRESSION_BLOCK_SIZE;
+            });
+        }
+    };
+
+    // Arrays are allocated from the memory resource of the index holding the postings.
+    using allocator_type = pmr::polymorphic_allocator<byte>;
+
+    PostingList() = default;
+
+    explicit PostingList(const allocator_type& allocator)
+        : document_ids_(allocator), term_freqs_(allocator), bytes_(allocator),
+          block_first_ids_(allocator), block_offsets_(allocator) {}
+
+    PostingList(const PostingList& other, const allocator_type& allocator) : PostingList(allocator) {
+        *this = other;
+    }
+
+    PostingList(PostingList&& other, const allocator_type& allocator) : PostingList(allocator) {
+        *this = move(other);
+    }
+
+    PostingList(const PostingList&) = default;
+    PostingList(PostingList&&) = default;
+    PostingList& operator=(const PostingList&) = default;
+    PostingList& operator=(PostingList&&) = default;
+
+    // Borrowed ids index arrays of documents, so they must increase and stay below
+    // the id limit. They're checked on first access rather than here, so that
+    // borrowing doesn't depend on the number of postings.
+    static PostingList Borrow(const int* document_ids, const double* term_freqs, size_t size, double max_term_freq,
+                              int id_limit) {
+        PostingList postings;
+        postings.borrowed_document_ids_ = document_ids;
+        postings.borrowed_term_freqs_ = term_freqs;
+        postings.borrowed_size_ = size;
+        postings.borrowed_id_limit_ = id_limit;
+        postings.max_term_freq_ = max_term_freq;
+        postings.RefreshLogDocumentFreq();
+        return postings;
+    }
+
+    Iterator begin() const {
+        return {GetDocumentIds(), GetTermFreqs(), 0};
+    }
+
+    Iterator end() const {
+        return {GetDocumentIds(), GetTermFreqs(), size()};
+    }
+
+    size_t size() const {
+        if (IsCompressed()) {
+            return compressed_size_;
+        }
+        return IsBorrowed() ? borrowed_size_ : document_ids_.size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    // Throws runtime_error on the first access to invalid borrowed ids.
+    const int* GetDocumentIds() const {
+        if (IsBorrowed() && !are_borrowed_ids_checked_.value.load(memory_order_acquire)) {
+            CheckBorrowedIds();
+        }
+        return IsBorrowed() ? borrowed_document_ids_ : document_ids_.data();
+    }
+
+    // Makes the first access ahead of time, for callers which can't let it throw
+    // later, such as threads of parallel algorithms.
+    void CheckDocumentIds() const {
+        (void) GetDocumentIds();
+    }
+
+    const double* GetTermFreqs() const {
+        return IsBorrowed() ? borrowed_term_freqs_ : term_freqs_.data();
+    }
+
+    bool Contains(int document_id) const {
+        if (!IsCompressed()) {
+            return binary_search(GetDocumentIds(), GetDocumentIds() + size(), document_id);
+        }
+        bool found = false;
+        DecodeFromBlock(FindBlock(document_id), [document_id, &found](int id, uint32_t) {
+            found = id == document_id;
+            return id < document_id;
+        });
+        return found;
+    }
+
+    bool IsCompressed() const {
+        return is_compressed_;
+    }
+
+    // Replaces the arrays with a byte stream holding per posting the varint of
+    // (id delta << 1 | repeated), followed by the varint of count - 1 for words
+    // repeated in the document. Every COMPRESSION_BLOCK_SIZE postings start
+    // a block with delta 0 whose first id and offset are kept aside, so that
+    // a lookup decodes a single block. Term frequency must be the number of
+    // the word's occurrences times the document's inverse word count, otherwise
+    // the list stays uncompressed and false is returned.
+    bool Compress(const double* inverse_word_counts) {
+        if (IsCompressed()) {
+            return true;
+        }
+        const int* document_ids = GetDocumentIds();
+        const double* term_freqs = GetTermFreqs();
+        const size_t posting_count = size();
+        vector<uint32_t> term_counts(posting_count);
+        for (size_t i = 0; i < posting_count; ++i) {
+            const double inverse_word_count = inverse_word_counts[document_ids[i]];
+            const double term_count = round(term_freqs[i] / inverse_word_count);
+            if (!(term_count >= 1 && term_count <= numeric_limits<uint32_t>::max())
+                || term_count * inverse_word_count != term_freqs[i]) {
+                return false;
+            }
+            term_counts[i] = static_cast<uint32_t>(term_count);
+        }
+        bytes_.reserve(posting_count * 2);
+        is_compressed_ = true;
+        compressed_size_ = 0;
+        // The number of postings stays the same.
+        const bool is_log_document_freq_stale = is_log_document_freq_stale_;
+        for (size_t i = 0; i < posting_count; ++i) {
+            Append(document_ids[i], term_counts[i], inverse_word_counts[document_ids[i]]);
+        }
+        is_log_document_freq_stale_ = is_log_document_freq_stale;
+        bytes_.shrink_to_fit();
+        document_ids_.clear();
+        document_ids_.shrink_to_fit();
+        term_freqs_.clear();
+        term_freqs_.shrink_to_fit();
+        borrowed_document_ids_ = nullptr;
+        borrowed_term_freqs_ = nullptr;
+        borrowed_size_ = 0;
+        return true;
+    }
+
+    void Decompress(const double* inverse_word_counts) {
+        if (!IsCompressed()) {
+            return;
+        }
+        pmr::vector<int> document_ids(document_ids_.get_allocator());
+        pmr::vector<double> term_freqs(term_freqs_.get_allocator());
+        document_ids.reserve(compressed_size_);
+        term_freqs.reserve(compressed_size_);
+        ForEachPosting(inverse_word_counts, [&](int document_id, double term_freq) {
+            document_ids.push_back(document_id);
+            term_freqs.push_back(term_freq);
+        });
+        document_ids_.swap(document_ids);
+        term_freqs_.swap(term_freqs);
+        bytes_.clear();
+        bytes_.shrink_to_fit();
+        block_first_ids_.clear();
+        block_first_ids_.shrink_to_fit();
+        block_offsets_.clear();
+        block_offsets_.shrink_to_fit();
+        is_compressed_ = false;
+        compressed_size_ = 0;
+    }
+
+    // Appends to compressed postings, the id must be greater than all ids in the list.
+    void Append(int document_id, uint32_t term_count, double inverse_word_count) {
+        if (compressed_size_ % COMPRESSION_BLOCK_SIZE == 0) {
+            block_first_ids_.push_back(document_id);
+            block_offsets_.push_back(bytes_.size());
+            last_document_id_ = document_id;
+        }
+        const uint32_t delta = document_id - last_document_id_;
+        WriteVarint(static_cast<uint64_t>(delta) << 1 | (term_count > 1), bytes_);
+        if (term_count > 1) {
+            WriteVarint(term_count - 1, bytes_);
+        }
+        last_document_id_ = document_id;
+        ++compressed_size_;
+        max_term_freq_ = max(max_term_freq_, term_count * inverse_word_count);
+        is_log_document_freq_stale_ = true;
+    }
+
+    // Calls function(document_id, term_freq) for postings with ids in [first_id, last_id)
+    // in any representation.
+    template<typename Function>
+    void ForEachPosting(const double* inverse_word_counts, int first_id, int last_id, Function function) const {
+        if (!IsCompressed()) {
+            const int* document_ids = GetDocumentIds();
+            const double* term_freqs = GetTermFreqs();
+            for (size_t i = lower_bound(document_ids, document_ids + size(), first_id) - document_ids;
+                 i < size() && document_ids[i] < last_id; ++i) {
+                function(document_ids[i], term_freqs[i]);
+            }
+            return;
+        }
+        DecodeFromBlock(FindBlock(first_id), [&](int document_id, uint32_t term_count) {
+            if (document_id >= last_id) {
+                return false;
+            }
+            if (document_id >= first_id) {
+                function(document_id, term_count * inverse_word_counts[document_id]);
+            }
+            return true;
+        });
+    }
+
+    // Calls function(document_ids, term_freqs, size) for consecutive runs of postings
+    // with ids in [first_id, last_id). Uncompressed postings make a single run right
+    // in their arrays. Compressed ones are decoded a block at a time into a buffer,
+    // so their runs stay valid only during the call.
+    template<typename Function>
+    void ForEachPostingRun(const double* inverse_word_counts, int first_id, int last_id, Function function) const {
+        if (!IsCompressed()) {
+            const int* document_ids = GetDocumentIds();
+            const int* begin = lower_bound(document_ids, document_ids + size(), first_id);
+            const int* end = lower_bound(begin, document_ids + size(), last_id);
+            if (begin != end) {
+                function(begin, GetTermFreqs() + (begin - document_ids), static_cast<size_t>(end - begin));
+            }
+            return;
+        }
+        array<int, COMPRESSION_BLOCK_SIZE> document_ids;
+        array<double, COMPRESSION_BLOCK_SIZE> term_freqs;
+        size_t count = 0;
+        DecodeFromBlock(FindBlock(first_id), [&](int document_id, uint32_t term_count) {
+            if (document_id >= last_id) {
+                return false;
+            }
+            if (document_id >= first_id) {
+                document_ids[count] = document_id;
+                term_freqs[count] = term_count * inverse_word_counts[document_id];
+                if (++count == COMPRESSION_BLOCK_SIZE) {
+                    function(document_ids.data(), term_freqs.data(), count);
+                    count = 0;
+                }
+            }
+            return true;
+        });
+        if (count > 0) {
+            function(document_ids.data(), term_freqs.data(), count);
+        }
+    }
+
+    template<typename Function>
+    void ForEachPosting(const double* inverse_word_counts, Function function) const {
+        ForEachPosting(inverse_word_counts, 0, numeric_limits<int>::max(), function);
+    }
+
+    // Logarithm of the number of documents containing the word, so that computing
+    // IDF takes no logarithm at query time. Changes of the list only mark it stale,
+    // the index refreshes it once per changed word when it's done changing the list.
+    double GetLogDocumentFreq() const {
+        return log_document_freq_;
+    }
+
+    void RefreshLogDocumentFreq() {
+        if (is_log_document_freq_stale_) {
+            log_document_freq_ = empty() ? 0 : log(static_cast<double>(size()));
+            is_log_document_freq_stale_ = false;
+        }
+    }
+
+    // IDF saved by the index, which decides when to recompute it.
+    double GetInverseDocumentFreq() const {
+        return inverse_document_freq_;
+    }
+
+    void SetInverseDocumentFreq(double inverse_document_freq) {
+        inverse_document_freq_ = inverse_document_freq;
+    }
+
+    // Largest term frequency in the list, bounds the word's contribution to relevance.
+    double GetMaxTermFreq() const {
+        return max_term_freq_;
+    }
+
+    // Documents usually arrive in increasing id order, so insertion is an append.
+    void Insert(int document_id, double term_freq) {
+        Own();
+        if (document_ids_.empty() || document_ids_.back() < document_id) {
+            document_ids_.push_back(document_id);
+            term_freqs_.push_back(term_freq);
+            max_term_freq_ = max(max_term_freq_, term_freq);
+            is_log_document_freq_stale_ = true;
+            return;
+        }
+        const auto it = lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+        const auto index = it - document_ids_.begin();
+        if (it != document_ids_.end() && *it == document_id) {
+            term_freqs_[index] += term_freq;
+            max_term_freq_ = max(max_term_freq_, term_freqs_[index]);
+            return;
+        }
+        document_ids_.insert(it, document_id);
+        term_freqs_.insert(term_freqs_.begin() + index, term_freq);
+        max_term_freq_ = max(max_term_freq_, term_freq);
+        is_log_document_freq_stale_ = true;
+    }
+
+    void Erase(int document_id) {
+        Own();
+        const auto it = lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+        if (it == document_ids_.end() || *it != document_id) {
+            return;
+        }
+        const auto term_freq_it = term_freqs_.begin() + (it - document_ids_.begin());
+        const bool was_max = *term_freq_it >= max_term_freq_;
+        term_freqs_.erase(term_freq_it);
+        document_ids_.erase(it);
+        if (was_max) {
+            max_term_freq_ = term_freqs_.empty() ? 0 : *max_element(term_freqs_.begin(), term_freqs_.end());
+        }
+        is_log_document_freq_stale_ = true;
+    }
+
+    size_t GetMemoryUsage() const {
+        return sizeof(*this)
+            + document_ids_.capacity() * sizeof(int)
+            + term_freqs_.capacity() * sizeof(double)
+            + borrowed_size_ * (sizeof(int) + sizeof(double))
+            + bytes_.capacity()
+            + block_first_ids_.capacity() * sizeof(int)
+            + block_offsets_.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    pmr::vector<int> document_ids_;
+    pmr::vector<double> term_freqs_;
+    const int* borrowed_document_ids_ = nullptr;
+    const double* borrowed_term_freqs_ = nullptr;
+    size_t borrowed_size_ = 0;
+    int borrowed_id_limit_ = 0;
+    // Concurrent queries may check the same ids, they set the flag to the same value.
+    struct CheckFlag {
+        CheckFlag() = default;
+
+        CheckFlag(const CheckFlag& other) : value(other.value.load(memory_order_acquire)) {}
+
+        CheckFlag& operator=(const CheckFlag& other) {
+            value.store(other.value.load(memory_order_acquire), memory_order_release);
+            return *this;
+        }
+
+        atomic<bool> value = false;
+    };
+    mutable CheckFlag are_borrowed_ids_checked_;
+    // Compressed representation.
+    pmr::vector<uint8_t> bytes_;
+    pmr::vector<int> block_first_ids_;
+    pmr::vector<uint32_t> block_offsets_;
+    size_t compressed_size_ = 0;
+    int last_document_id_ = 0;
+    bool is_compressed_ = false;
+    double log_document_freq_ = 0;
+    bool is_log_document_freq_stale_ = true;
+    double inverse_document_freq_ = 0;
+    double max_term_freq_ = 0;
+
+    static void WriteVarint(uint64_t value, pmr::vector<uint8_t>& bytes) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    static uint64_t ReadVarint(const uint8_t*& data) {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            const uint8_t byte = *data++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (byte < 0x80) {
+                return value;
+            }
+        }
+    }
+
+    // Index of the last block starting not after the id.
+    size_t FindBlock(int document_id) const {
+        const auto it = upper_bound(block_first_ids_.begin(), block_first_ids_.end(), document_id);
+        return it == block_first_ids_.begin() ? 0 : it - block_first_ids_.begin() - 1;
+    }
+
+    // Decodes postings starting from the block while visit(document_id, term_count) returns true.
+    template<typename Visitor>
+    void DecodeFromBlock(size_t block, Visitor visit) const {
+        if (block >= block_first_ids_.size()) {
+            return;
+        }
+        const uint8_t* data = bytes_.data() + block_offsets_[block];
+        int document_id = 0;
+        for (size_t i = block * COMPRESSION_BLOCK_SIZE; i < compressed_size_; ++i) {
+            if (i % COMPRESSION_BLOCK_SIZE == 0) {
+                document_id = block_first_ids_[i / COMPRESSION_BLOCK_SIZE];
+            }
+            const uint64_t value = ReadVarint(data);
+            document_id += static_cast<int>(value >> 1);
+            const uint32_t term_count = (value & 1) ? static_cast<uint32_t>(ReadVarint(data)) + 1 : 1;
+            if (!visit(document_id, term_count)) {
+                return;
+            }
+        }
+    }
+
+    bool IsBorrowed() const {
+        return borrowed_document_ids_ != nullptr;
+    }
+
+    void CheckBorrowedIds() const {
+        for (size_t i = 0; i < borrowed_size_; ++i) {
+            if (borrowed_document_ids_[i] < (i == 0 ? 0 : borrowed_document_ids_[i - 1] + 1)
+                || borrowed_document_ids_[i] >= borrowed_id_limit_) {
+                throw(runtime_error("Invalid posting in snapshot"s));
+            }
+        }
+        are_borrowed_ids_checked_.value.store(true, memory_order_release);
+    }
+
+    void Own() {
+        if (!IsBorrowed()) {
+            return;
+        }
+        document_ids_.assign(GetDocumentIds(), GetDocumentIds() + borrowed_size_);
+        term_freqs_.assign(borrowed_term_freqs_, borrowed_term_freqs_ + borrowed_size_);
+        borrowed_document_ids_ = nullptr;
+        borrowed_term_freqs_ = nullptr;
+        borrowed_size_ = 0;
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+// Prints elements of a container separated by commas.
+template<typename Container>
+void Print(ostream& o, const Container& container) {
+    bool is_first = true;
+    for (const auto& element : container) {
+        if (!is_first) {
+            o << ", "s;
+        }
+        is_first = false;
+        o << element;
+    }
+}
+
+template<typename Key, typename Value>
+void Print(ostream& o, const map<Key, Value>& container) {
+    bool is_first = true;
+    for (const auto& [key, value] : container) {
+        if (!is_first) {
+            o << ", "s;
+        }
+        is_first = false;
+        o << key << ": "s << value;
+    }
+}
+
+template<typename Any>
+ostream& operator<<(ostream& o, const vector<Any>& container) {
+    o << "["s;
+    Print(o, container);
+    o << "]"s;
+    return o;
+}
+
+template<typename Any, typename Compare>
+ostream& operator<<(ostream& o, const set<Any, Compare>& container) {
+    o << "{"s;
+    Print(o, container);
+    o << "}"s;
+    return o;
+}
+
+template<typename Key, typename Value>
+ostream& operator<<(ostream& o, const map<Key, Value>& container) {
+    o << "{"s;
+    Print(o, container);
+    o << "}"s;
+    return o;
+}
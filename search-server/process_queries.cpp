@@ -0,0 +1,35 @@
+#include "process_queries.h"
+
+#include <algorithm>
+#include <exception>
+#include <execution>
+
+using namespace std;
+
+vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const vector<string>& queries) {
+    vector<vector<Document>> documents_lists(queries.size());
+    // Parallel algorithms terminate on escaping exceptions, so errors are collected
+    // per query and the first one is rethrown, as a sequential loop would do.
+    vector<exception_ptr> errors(queries.size());
+    transform(execution::par, queries.begin(), queries.end(), errors.begin(), documents_lists.begin(),
+        [&search_server](const string& query, exception_ptr& error) {
+            try {
+                return search_server.FindTopDocuments(query);
+            } catch (...) {
+                error = current_exception();
+                return vector<Document>{};
+            }
+        }
+    );
+    for (const exception_ptr& error : errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+    return documents_lists;
+}
+
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const vector<string>& queries) {
+    return JoinedDocuments(ProcessQueries(search_server, queries));
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const vector<string>& queries);
+
+// Flat read-only sequence over results of several queries.
+// Documents stay in their per-query vectors and are visited in query order.
+class JoinedDocuments {
+public:
+    class Iterator {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = Document;
+        using difference_type = ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+
+        Iterator(const vector<vector<Document>>* documents_lists, size_t list_index)
+            : documents_lists_(documents_lists), list_index_(list_index) {
+            SkipEmptyLists();
+        }
+
+        reference operator*() const {
+            return (*documents_lists_)[list_index_][document_index_];
+        }
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        Iterator& operator++() {
+            if (++document_index_ == (*documents_lists_)[list_index_].size()) {
+                ++list_index_;
+                document_index_ = 0;
+                SkipEmptyLists();
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return list_index_ == other.list_index_ && document_index_ == other.document_index_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const vector<vector<Document>>* documents_lists_;
+        size_t list_index_;
+        size_t document_index_ = 0;
+
+        void SkipEmptyLists() {
+            while (list_index_ < documents_lists_->size() && (*documents_lists_)[list_index_].empty()) {
+                ++list_index_;
+            }
+        }
+    };
+
+    explicit JoinedDocuments(vector<vector<Document>> documents_lists)
+        : documents_lists_(move(documents_lists)) {
+        for (const auto& documents : documents_lists_) {
+            size_ += documents.size();
+        }
+    }
+
+    Iterator begin() const {
+        return {&documents_lists_, 0};
+    }
+
+    Iterator end() const {
+        return {&documents_lists_, documents_lists_.size()};
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+private:
+    vector<vector<Document>> documents_lists_;
+    size_t size_ = 0;
+};
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const vector<string>& queries);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+using namespace std;
+
+struct QueryCacheStats {
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+};
+
+// LRU cache of search results. Entries belong to a generation of the index
+// and the whole cache is dropped once a lookup comes with a newer one.
+class QueryCache {
+public:
+    explicit QueryCache(size_t capacity)
+        : capacity_(capacity) {
+        if (capacity_ == 0) {
+            throw(invalid_argument("Query cache capacity can't be zero"s));
+        }
+    }
+
+    optional<vector<Document>> Find(const string& key, uint64_t generation) {
+        lock_guard guard(mutex_);
+        DropStaleEntries(generation);
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            ++stats_.miss_count;
+            return nullopt;
+        }
+        ++stats_.hit_count;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+    }
+
+    void Insert(const string& key, uint64_t generation, const vector<Document>& documents) {
+        lock_guard guard(mutex_);
+        DropStaleEntries(generation);
+        if (index_.count(key) != 0) {
+            return;
+        }
+        entries_.emplace_front(key, documents);
+        index_.emplace(entries_.front().first, entries_.begin());
+        if (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+
+    QueryCacheStats GetStats() const {
+        lock_guard guard(mutex_);
+        return stats_;
+    }
+
+private:
+    using Entry = pair<string, vector<Document>>;
+
+    const size_t capacity_;
+    mutable mutex mutex_;
+    uint64_t generation_ = 0;
+    // Most recently used entries come first.
+    list<Entry> entries_;
+    unordered_map<string_view, list<Entry>::iterator> index_;
+    QueryCacheStats stats_;
+
+    void DropStaleEntries(uint64_t generation) {
+        if (generation != generation_) {
+            index_.clear();
+            entries_.clear();
+            generation_ = generation;
+        }
+    }
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory_resource>
+
+using namespace std;
+
+// Scratch memory of queries. Everything a thread allocates while a scope is open
+// is released at once when its outermost scope closes. Released memory stays
+// in a thread-local pool, so queries don't go to the global heap once warmed up.
+class QueryScratch {
+public:
+    QueryScratch() {
+        ++GetArena().depth;
+    }
+
+    QueryScratch(const QueryScratch&) = delete;
+    QueryScratch& operator=(const QueryScratch&) = delete;
+
+    ~QueryScratch() {
+        Arena& arena = GetArena();
+        if (--arena.depth == 0) {
+            arena.resource.release();
+        }
+    }
+
+    pmr::memory_resource* GetResource() const {
+        return &GetArena().resource;
+    }
+
+private:
+    struct Arena {
+        pmr::unsynchronized_pool_resource pool{pmr::pool_options{0, 1 << 22}};
+        pmr::monotonic_buffer_resource resource{&pool};
+        int depth = 0;
+    };
+
+    static Arena& GetArena() {
+        thread_local Arena arena;
+        return arena;
+    }
+};
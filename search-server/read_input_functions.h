@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+string ReadLine();
+
+int ReadLineWithNumber();
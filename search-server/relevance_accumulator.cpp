@@ -0,0 +1,130 @@
+#include "relevance_accumulator.h"
+
+// Vectorized kernels are built with GCC function targets and chosen at runtime.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SEARCH_SERVER_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Adds term_freqs[i] * inverse_document_freq to scores[document_ids[i] - first_id]
+// and sets the corresponding bits of matched. Ids are sorted and unique within a call,
+// so vector lanes never write the same score.
+void AccumulateRelevanceScalar(double* scores, uint64_t* matched, const int* document_ids, const double* term_freqs,
+                               size_t size, double inverse_document_freq, int first_id) {
+    for (size_t i = 0; i < size; ++i) {
+        const int id = document_ids[i] - first_id;
+        scores[id] += term_freqs[i] * inverse_document_freq;
+        matched[id / 64] |= uint64_t{1} << (id % 64);
+    }
+}
+
+// Stores matched AND NOT excluded into mask.
+void CombineMatchMaskScalar(const uint64_t* matched, const uint64_t* excluded, uint64_t* mask, size_t word_count) {
+    for (size_t w = 0; w < word_count; ++w) {
+        mask[w] = matched[w] & ~excluded[w];
+    }
+}
+
+#ifdef SEARCH_SERVER_X86_KERNELS
+
+__attribute__((target("avx2")))
+void AccumulateRelevanceAvx2(double* scores, uint64_t* matched, const int* document_ids, const double* term_freqs,
+                             size_t size, double inverse_document_freq, int first_id) {
+    const __m256d idf = _mm256_set1_pd(inverse_document_freq);
+    const __m128i first = _mm_set1_epi32(first_id);
+    // Gathers take an explicit source and mask, the unmasked form starts from
+    // an undefined vector which GCC reports as uninitialized.
+    const __m256d all_lanes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    size_t i = 0;
+    // AVX2 has no scatter, gathered scores are written back lane by lane.
+    for (; i + 4 <= size; i += 4) {
+        const __m128i index = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(document_ids + i)), first);
+        const __m256d gathered = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), scores, index, all_lanes, 8);
+        const __m256d score = _mm256_add_pd(gathered, _mm256_mul_pd(_mm256_loadu_pd(term_freqs + i), idf));
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, score);
+        for (int lane = 0; lane < 4; ++lane) {
+            const int id = document_ids[i + lane] - first_id;
+            scores[id] = lanes[lane];
+            matched[id / 64] |= uint64_t{1} << (id % 64);
+        }
+    }
+    AccumulateRelevanceScalar(scores, matched, document_ids + i, term_freqs + i, size - i, inverse_document_freq, first_id);
+}
+
+__attribute__((target("avx2")))
+void CombineMatchMaskAvx2(const uint64_t* matched, const uint64_t* excluded, uint64_t* mask, size_t word_count) {
+    size_t w = 0;
+    for (; w + 4 <= word_count; w += 4) {
+        const __m256i matched_bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(matched + w));
+        const __m256i excluded_bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(excluded + w));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(mask + w), _mm256_andnot_si256(excluded_bits, matched_bits));
+    }
+    CombineMatchMaskScalar(matched + w, excluded + w, mask + w, word_count - w);
+}
+
+__attribute__((target("avx512f")))
+void AccumulateRelevanceAvx512(double* scores, uint64_t* matched, const int* document_ids, const double* term_freqs,
+                               size_t size, double inverse_document_freq, int first_id) {
+    const __m512d idf = _mm512_set1_pd(inverse_document_freq);
+    const __m256i first = _mm256_set1_epi32(first_id);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        const __m256i index = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(document_ids + i)), first);
+        const __m512d gathered = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, index, scores, 8);
+        const __m512d score = _mm512_add_pd(gathered, _mm512_mul_pd(_mm512_loadu_pd(term_freqs + i), idf));
+        _mm512_i32scatter_pd(scores, index, score, 8);
+        // Neighbouring ids often share a bitset word, bits are set one by one.
+        for (int lane = 0; lane < 8; ++lane) {
+            const int id = document_ids[i + lane] - first_id;
+            matched[id / 64] |= uint64_t{1} << (id % 64);
+        }
+    }
+    AccumulateRelevanceScalar(scores, matched, document_ids + i, term_freqs + i, size - i, inverse_document_freq, first_id);
+}
+
+__attribute__((target("avx512f")))
+void CombineMatchMaskAvx512(const uint64_t* matched, const uint64_t* excluded, uint64_t* mask, size_t word_count) {
+    size_t w = 0;
+    for (; w + 8 <= word_count; w += 8) {
+        const __m512i matched_bits = _mm512_loadu_si512(matched + w);
+        // The zero-masked form, the unmasked one merges into an undefined vector.
+        _mm512_storeu_si512(mask + w, _mm512_maskz_andnot_epi64(0xFF, _mm512_loadu_si512(excluded + w), matched_bits));
+    }
+    CombineMatchMaskScalar(matched + w, excluded + w, mask + w, word_count - w);
+}
+
+#endif
+
+SimdLevel DetectSimdLevel() {
+#ifdef SEARCH_SERVER_X86_KERNELS
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return SimdLevel::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::AVX2;
+        }
+        return SimdLevel::SCALAR;
+    }();
+    return level;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+RelevanceKernels GetRelevanceKernels(SimdLevel level) {
+    level = min(level, DetectSimdLevel());
+#ifdef SEARCH_SERVER_X86_KERNELS
+    if (level == SimdLevel::AVX512) {
+        return {AccumulateRelevanceAvx512, CombineMatchMaskAvx512};
+    }
+    if (level == SimdLevel::AVX2) {
+        return {AccumulateRelevanceAvx2, CombineMatchMaskAvx2};
+    }
+#endif
+    return {AccumulateRelevanceScalar, CombineMatchMaskScalar};
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+enum class SimdLevel {
+    SCALAR,
+    AVX2,
+    AVX512,
+};
+
+SimdLevel DetectSimdLevel();
+
+struct RelevanceKernels {
+    void (*accumulate_relevance)(double* scores, uint64_t* matched, const int* document_ids, const double* term_freqs,
+                                 size_t size, double inverse_document_freq, int first_id);
+    void (*combine_match_mask)(const uint64_t* matched, const uint64_t* excluded, uint64_t* mask, size_t word_count);
+};
+
+// Levels the CPU doesn't support fall back to the best supported one.
+RelevanceKernels GetRelevanceKernels(SimdLevel level);
+
+// Relevance of documents accumulated in a dense score array indexed by document id.
+// Plus words set bits in matched_ and minus words in excluded_, documents of the
+// result are matched_ AND NOT excluded_. Bitsets are split into blocks of BLOCK_WORDS
+// words with a summary bit per touched block, so that clearing visits only those.
+class RelevanceAccumulator {
+public:
+    explicit RelevanceAccumulator(SimdLevel level = DetectSimdLevel())
+        : kernels_(GetRelevanceKernels(level)) {
+    }
+
+    // Prepares the accumulator for documents with ids in [0, document_count).
+    // Extraction zeroes the scores it passes on, so only excluded documents keep theirs;
+    // after a query interrupted before extraction every touched block is zeroed.
+    void Reset(size_t document_count) {
+        if (has_pending_scores_) {
+            ForEachBlock(matched_summary_, [this](size_t block) {
+                fill(scores_.begin() + block * BLOCK_SIZE, scores_.begin() + (block + 1) * BLOCK_SIZE, 0.0);
+            });
+        }
+        ForEachBlock(excluded_summary_, [this](size_t block) {
+            for (size_t w = block * BLOCK_WORDS; w < (block + 1) * BLOCK_WORDS; ++w) {
+                for (uint64_t bits = matched_[w] & excluded_[w]; bits != 0; bits &= bits - 1) {
+                    scores_[w * 64 + __builtin_ctzll(bits)] = 0;
+                }
+                excluded_[w] = 0;
+            }
+        });
+        ForEachBlock(matched_summary_, [this](size_t block) {
+            fill(matched_.begin() + block * BLOCK_WORDS, matched_.begin() + (block + 1) * BLOCK_WORDS, 0);
+        });
+        fill(matched_summary_.begin(), matched_summary_.end(), 0);
+        fill(excluded_summary_.begin(), excluded_summary_.end(), 0);
+        plus_postings_.clear();
+        plus_posting_count_ = 0;
+        has_transient_postings_ = false;
+        has_pending_scores_ = false;
+
+        const size_t block_count = (document_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if (matched_.size() < block_count * BLOCK_WORDS) {
+            scores_.resize(block_count * BLOCK_SIZE);
+            matched_.resize(block_count * BLOCK_WORDS);
+            excluded_.resize(block_count * BLOCK_WORDS);
+            mask_.resize(block_count * BLOCK_WORDS);
+            matched_summary_.resize((block_count + 63) / 64);
+            excluded_summary_.resize((block_count + 63) / 64);
+        }
+    }
+
+    // Ids are sorted and unique, first_id is subtracted from each of them.
+    void Exclude(const int* document_ids, size_t size, int first_id) {
+        for (size_t i = 0; i < size; ++i) {
+            const int id = document_ids[i] - first_id;
+            SetBit(excluded_, id);
+            SetBit(excluded_summary_, id / BLOCK_SIZE);
+        }
+    }
+
+    // Ids must stay valid until the matched documents are extracted.
+    void Add(const int* document_ids, const double* term_freqs, size_t size, double inverse_document_freq, int first_id) {
+        Accumulate(document_ids, term_freqs, size, inverse_document_freq, first_id);
+        plus_postings_.push_back({document_ids, size, first_id});
+        plus_posting_count_ += size;
+    }
+
+    // Ids may be overwritten right after the call, as decoded ones are. Matched
+    // documents are then found by scanning the bitsets.
+    void AddTransient(const int* document_ids, const double* term_freqs, size_t size, double inverse_document_freq,
+                      int first_id) {
+        Accumulate(document_ids, term_freqs, size, inverse_document_freq, first_id);
+        has_transient_postings_ = true;
+    }
+
+    // Excludes matched documents missing from a bitset over ids offset by first_id,
+    // bit first_id + id stands for the id. Called after all plus words are added.
+    void Restrict(const uint64_t* bits, size_t word_count, int first_id) {
+        ForEachBlock(matched_summary_, [&](size_t block) {
+            for (size_t w = block * BLOCK_WORDS; w < (block + 1) * BLOCK_WORDS; ++w) {
+                excluded_[w] |= matched_[w] & ~ReadBits(bits, word_count, first_id + w * 64);
+            }
+            SetBit(excluded_summary_, block);
+        });
+    }
+
+    // Passes every matched document with its relevance to the function, may be called once per Reset.
+    // Sparse results are found by walking the plus words' postings again, since scanning
+    // a bitset with a bit in every few words mostly costs mispredicted branches.
+    // Dense results are found by scanning the bitsets, combined by the vectorized kernel.
+    template <typename Function>
+    void ExtractMatched(Function function) {
+        size_t first_block = numeric_limits<size_t>::max();
+        size_t last_block = 0;
+        ForEachBlock(matched_summary_, [&first_block, &last_block](size_t block) {
+            first_block = min(first_block, block);
+            last_block = block + 1;
+        });
+        if (first_block >= last_block) {
+            has_pending_scores_ = false;
+            return;
+        }
+        const size_t first_word = first_block * BLOCK_WORDS;
+        const size_t last_word = last_block * BLOCK_WORDS;
+        // Scores that weren't extracted because the function threw are cleared by Reset.
+        if (!has_transient_postings_ && plus_posting_count_ < (last_word - first_word) * DENSE_POSTINGS_PER_WORD) {
+            ExtractSparse(function);
+        } else {
+            ExtractDense(first_word, last_word, function);
+        }
+        has_pending_scores_ = false;
+    }
+
+private:
+    // A block of bitset words fills one AVX-512 register.
+    static constexpr size_t BLOCK_WORDS = 8;
+    static constexpr size_t BLOCK_SIZE = BLOCK_WORDS * 64;
+    static constexpr size_t DENSE_POSTINGS_PER_WORD = 4;
+
+    struct Postings {
+        const int* document_ids;
+        size_t size;
+        int first_id;
+    };
+
+    RelevanceKernels kernels_;
+    vector<double> scores_;
+    vector<uint64_t> matched_;
+    vector<uint64_t> excluded_;
+    vector<uint64_t> mask_;
+    vector<uint64_t> matched_summary_;
+    vector<uint64_t> excluded_summary_;
+    vector<Postings> plus_postings_;
+    size_t plus_posting_count_ = 0;
+    bool has_transient_postings_ = false;
+    // Set once scores are accumulated, cleared when all of them are extracted.
+    bool has_pending_scores_ = false;
+
+    void Accumulate(const int* document_ids, const double* term_freqs, size_t size, double inverse_document_freq,
+                    int first_id) {
+        kernels_.accumulate_relevance(scores_.data(), matched_.data(), document_ids, term_freqs, size,
+                                      inverse_document_freq, first_id);
+        has_pending_scores_ = true;
+        for (size_t i = 0; i < size; ++i) {
+            SetBit(matched_summary_, (document_ids[i] - first_id) / BLOCK_SIZE);
+        }
+    }
+
+    // Each document is taken once, its matched bit is cleared when it is reached first.
+    template <typename Function>
+    void ExtractSparse(Function& function) {
+        for (const Postings& postings : plus_postings_) {
+            for (size_t i = 0; i < postings.size; ++i) {
+                const int id = postings.document_ids[i] - postings.first_id;
+                const uint64_t bit = uint64_t{1} << (id % 64);
+                if ((matched_[id / 64] & bit) == 0) {
+                    continue;
+                }
+                matched_[id / 64] &= ~bit;
+                const double relevance = scores_[id];
+                scores_[id] = 0;
+                if ((excluded_[id / 64] & bit) == 0) {
+                    function(id, relevance);
+                }
+            }
+        }
+    }
+
+    template <typename Function>
+    void ExtractDense(size_t first_word, size_t last_word, Function& function) {
+        kernels_.combine_match_mask(matched_.data() + first_word, excluded_.data() + first_word,
+                                    mask_.data() + first_word, last_word - first_word);
+        for (size_t w = first_word; w < last_word; ++w) {
+            for (uint64_t bits = mask_[w]; bits != 0; bits &= bits - 1) {
+                const int document_id = w * 64 + __builtin_ctzll(bits);
+                const double relevance = scores_[document_id];
+                scores_[document_id] = 0;
+                function(document_id, relevance);
+            }
+        }
+    }
+
+    // 64 bits of the bitset starting from the index, bits past its end are zeros.
+    static uint64_t ReadBits(const uint64_t* bits, size_t word_count, size_t index) {
+        const size_t word = index / 64;
+        const size_t shift = index % 64;
+        const uint64_t low = word < word_count ? bits[word] >> shift : 0;
+        const uint64_t high = shift != 0 && word + 1 < word_count ? bits[word + 1] << (64 - shift) : 0;
+        return low | high;
+    }
+
+    static void SetBit(vector<uint64_t>& bitset, size_t index) {
+        bitset[index / 64] |= uint64_t{1} << (index % 64);
+    }
+
+    template <typename Function>
+    static void ForEachBlock(const vector<uint64_t>& summary, Function function) {
+        for (size_t w = 0; w < summary.size(); ++w) {
+            for (uint64_t bits = summary[w]; bits != 0; bits &= bits - 1) {
+                function(w * 64 + __builtin_ctzll(bits));
+            }
+        }
+    }
+};
@@ -0,0 +1,41 @@
+#include "remove_duplicates.h"
+
+#include <algorithm>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+vector<int> RemoveDuplicates(SearchServer& search_server) {
+    vector<int> document_ids(search_server.begin(), search_server.end());
+    sort(document_ids.begin(), document_ids.end());
+
+    unordered_map<size_t, vector<int>> signature_to_document_ids;
+    vector<int> duplicate_ids;
+    for (const int document_id : document_ids) {
+        const map<string_view, double>& word_freqs = search_server.GetWordFrequencies(document_id);
+        size_t signature = word_freqs.size();
+        for (const auto& [word, _] : word_freqs) {
+            signature ^= hash<string_view>{}(word) + 0x9e3779b97f4a7c15 + (signature << 6) + (signature >> 2);
+        }
+
+        vector<int>& same_signature_ids = signature_to_document_ids[signature];
+        const bool is_duplicate = any_of(same_signature_ids.begin(), same_signature_ids.end(), [&](int original_id) {
+            const map<string_view, double>& original_word_freqs = search_server.GetWordFrequencies(original_id);
+            return equal(word_freqs.begin(), word_freqs.end(), original_word_freqs.begin(), original_word_freqs.end(),
+                         [](const auto& lhs, const auto& rhs) { return lhs.first == rhs.first; });
+        });
+        if (is_duplicate) {
+            duplicate_ids.push_back(document_id);
+        } else {
+            same_signature_ids.push_back(document_id);
+        }
+    }
+
+    for (const int document_id : duplicate_ids) {
+        search_server.RemoveDocument(document_id);
+    }
+    return duplicate_ids;
+}
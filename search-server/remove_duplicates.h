@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+// Removes documents whose sets of words (regardless of frequencies) equal the set of
+// a document with a lower id. Documents are grouped by a hash of the word set, so
+// only documents with equal hashes are compared word by word.
+// Returns ids of the removed documents in increasing order.
+vector<int> RemoveDuplicates(SearchServer& search_server);
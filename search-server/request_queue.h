@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+// Forwards search requests to a SearchServer and keeps statistics over the last
+// MIN_IN_DAY requests, each request being counted as one minute.
+class RequestQueue {
+public:
+    explicit RequestQueue(const SearchServer& search_server) : search_server_(search_server) {}
+
+    // Accepts the same arguments as any SearchServer::FindTopDocuments overload.
+    template <typename... Args>
+    vector<Document> AddFindRequest(Args&&... args) {
+        vector<Document> documents = search_server_.FindTopDocuments(forward<Args>(args)...);
+        AddRequest(documents.size());
+        return documents;
+    }
+
+    int GetNoResultRequests() const {
+        return no_result_requests_;
+    }
+
+private:
+    struct QueryResult {
+        uint64_t timestamp;
+        size_t document_count;
+    };
+
+    static constexpr size_t MIN_IN_DAY = 1440;
+
+    const SearchServer& search_server_;
+    // Ring buffer, the request made at time t occupies the slot t % MIN_IN_DAY.
+    array<QueryResult, MIN_IN_DAY> requests_;
+    uint64_t current_time_ = 0;
+    int no_result_requests_ = 0;
+
+    void AddRequest(size_t document_count) {
+        QueryResult& slot = requests_[current_time_ % MIN_IN_DAY];
+        if (current_time_ >= MIN_IN_DAY && slot.document_count == 0) {
+            --no_result_requests_;
+        }
+        slot = {current_time_, document_count};
+        if (document_count == 0) {
+            ++no_result_requests_;
+        }
+        ++current_time_;
+    }
+};
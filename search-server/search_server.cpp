@@ -0,0 +1,642 @@
+#include "search_server.h"
+
+#include <cstring>
+#include <exception>
+#include <fstream>
+
+using namespace std;
+
+SearchServer::SearchServer(const SearchServer& other)
+    : stop_words_(other.stop_words_),
+      word_to_document_freqs_(other.GetMemoryResource()),
+      document_to_dense_id_(other.document_to_dense_id_, other.GetMemoryResource()),
+      dense_document_ids_(other.dense_document_ids_, other.GetMemoryResource()),
+      dense_ratings_(other.dense_ratings_, other.GetMemoryResource()),
+      dense_statuses_(other.dense_statuses_, other.GetMemoryResource()),
+      dense_inverse_word_counts_(other.dense_inverse_word_counts_, other.GetMemoryResource()),
+      document_columns_(other.document_columns_, other.GetMemoryResource()),
+      snapshot_(other.snapshot_),
+      log_document_count_(other.log_document_count_),
+      idf_refresh_interval_(other.idf_refresh_interval_),
+      mutations_since_idf_refresh_(other.mutations_since_idf_refresh_),
+      compress_postings_(other.compress_postings_),
+      query_evaluation_(other.query_evaluation_) {
+    if (other.query_cache_) {
+        EnableQueryCache(other.query_cache_->GetCapacity());
+    }
+    word_to_document_freqs_.reserve(other.word_to_document_freqs_.size());
+    for (const auto& [word, postings] : other.word_to_document_freqs_) {
+        word_to_document_freqs_.emplace(words_storage_.emplace_back(word), postings);
+    }
+    lock_guard guard(*other.word_freqs_mutex_);
+    has_word_freqs_ = other.has_word_freqs_;
+    for (const auto& [document_id, word_freqs] : other.document_to_word_freqs_) {
+        map<string_view, double>& stored_word_freqs = document_to_word_freqs_[document_id];
+        for (const auto& [word, term_freq] : word_freqs) {
+            stored_word_freqs.emplace_hint(stored_word_freqs.end(), word_to_document_freqs_.find(word)->first, term_freq);
+        }
+    }
+}
+
+SearchServer& SearchServer::operator=(const SearchServer& other) {
+    if (this != &other) {
+        *this = SearchServer(other);
+    }
+    return *this;
+}
+
+void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,
+                               const vector<int>& ratings) {
+    CheckNewDocumentId(document_id);
+    const vector<string_view> words = SplitIntoWordsNoStop(document);
+    const double inv_word_count = 1.0 / words.size();
+    // Term frequency is the count of the word times the inverse word count,
+    // compressed postings store only the count.
+    map<string_view, uint32_t> word_counts;
+    for (const string_view word : words) {
+        ++word_counts[word];
+    }
+    map<string_view, double> word_freqs;
+    for (const auto& [word, term_count] : word_counts) {
+        word_freqs.emplace_hint(word_freqs.end(), word, term_count * inv_word_count);
+    }
+    // Dense ids grow with every document, so postings are always appended to.
+    const int dense_id = dense_document_ids_.size();
+    document_to_dense_id_.emplace(document_id, dense_id);
+    dense_document_ids_.push_back(document_id);
+    dense_ratings_.push_back(ComputeAverageRating(ratings));
+    dense_statuses_.push_back(status);
+    document_columns_.Add(dense_id, status, dense_ratings_.back());
+    dense_inverse_word_counts_.push_back(inv_word_count);
+    UpdateLogDocumentCount();
+    auto word_count_it = word_counts.begin();
+    for (const auto& [word, term_freq] : word_freqs) {
+        PostingList& postings = GetOrAddWord(word).second;
+        const bool is_new_word = postings.empty();
+        if (compress_postings_ && is_new_word) {
+            postings.Compress(dense_inverse_word_counts_.data());
+        }
+        if (postings.IsCompressed()) {
+            postings.Append(dense_id, word_count_it->second, inv_word_count);
+        } else {
+            postings.Insert(dense_id, term_freq);
+        }
+        postings.RefreshLogDocumentFreq();
+        ++word_count_it;
+        // Stale IDFs are tolerated, but a word missing from the index had none.
+        if (is_new_word) {
+            postings.SetInverseDocumentFreq(ComputeExactInverseDocumentFreq(postings));
+        }
+    }
+    // Until the forward index is needed it is not maintained, it'll be built from postings.
+    if (has_word_freqs_) {
+        // Both maps order words by content, so stored words arrive in order.
+        map<string_view, double>& stored_word_freqs = document_to_word_freqs_[document_id];
+        for (const auto& [word, term_freq] : word_freqs) {
+            stored_word_freqs.emplace_hint(stored_word_freqs.end(), word_to_document_freqs_.find(word)->first, term_freq);
+        }
+    }
+    CountIndexMutation();
+}
+
+void SearchServer::AddDocuments(const vector<NewDocument>& documents) {
+    const int first_dense_id = dense_document_ids_.size();
+    // Ids are reserved in order, so that duplicates inside the batch are found as well.
+    size_t valid_count = documents.size();
+    exception_ptr error;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        try {
+            CheckNewDocumentId(documents[i].id);
+        } catch (...) {
+            valid_count = i;
+            error = current_exception();
+            break;
+        }
+        document_to_dense_id_.emplace(documents[i].id, first_dense_id + i);
+    }
+
+    struct TokenizedDocument {
+        // Sorted by word.
+        vector<pair<string_view, uint32_t>> word_counts;
+        double inverse_word_count = 0;
+    };
+    struct BatchPart {
+        size_t begin;
+        size_t end;
+        unordered_map<string_view, vector<pair<int, uint32_t>>> word_postings;
+        exception_ptr error;
+    };
+    vector<TokenizedDocument> tokenized_documents(valid_count);
+    const size_t part_count = min(valid_count, static_cast<size_t>(max(1u, thread::hardware_concurrency())) * 4);
+    vector<BatchPart> parts(part_count);
+    for (size_t part = 0; part < part_count; ++part) {
+        parts[part].begin = valid_count * part / part_count;
+        parts[part].end = valid_count * (part + 1) / part_count;
+    }
+    for_each(execution::par, parts.begin(), parts.end(), [&](BatchPart& part) {
+        for (size_t i = part.begin; i < part.end; ++i) {
+            TokenizedDocument& tokenized = tokenized_documents[i];
+            vector<string_view> words;
+            try {
+                words = SplitIntoWordsNoStop(documents[i].text);
+            } catch (...) {
+                part.end = i;
+                part.error = current_exception();
+                return;
+            }
+            tokenized.inverse_word_count = 1.0 / words.size();
+            sort(words.begin(), words.end());
+            for (const string_view word : words) {
+                if (tokenized.word_counts.empty() || tokenized.word_counts.back().first != word) {
+                    tokenized.word_counts.emplace_back(word, 0);
+                }
+                ++tokenized.word_counts.back().second;
+            }
+            for (const auto& [word, term_count] : tokenized.word_counts) {
+                part.word_postings[word].emplace_back(first_dense_id + i, term_count);
+            }
+        }
+    });
+    for (const BatchPart& part : parts) {
+        if (part.error) {
+            valid_count = part.end;
+            error = part.error;
+            break;
+        }
+    }
+    for (size_t i = valid_count; i < tokenized_documents.size(); ++i) {
+        document_to_dense_id_.erase(documents[i].id);
+    }
+
+    for (size_t i = 0; i < valid_count; ++i) {
+        const NewDocument& document = documents[i];
+        dense_document_ids_.push_back(document.id);
+        dense_ratings_.push_back(ComputeAverageRating(document.ratings));
+        dense_statuses_.push_back(document.status);
+        document_columns_.Add(first_dense_id + i, document.status, dense_ratings_.back());
+        dense_inverse_word_counts_.push_back(tokenized_documents[i].inverse_word_count);
+    }
+    UpdateLogDocumentCount();
+    const int last_dense_id = first_dense_id + valid_count;
+    // Words of several parts are changed several times, logarithms of their
+    // document frequencies are refreshed once after all of them.
+    vector<PostingList*> changed_words;
+    vector<PostingList*> new_words;
+    for (const BatchPart& part : parts) {
+        for (const auto& [word, word_postings] : part.word_postings) {
+            if (word_postings.front().first >= last_dense_id) {
+                continue;
+            }
+            PostingList& postings = GetOrAddWord(word).second;
+            changed_words.push_back(&postings);
+            if (postings.empty()) {
+                new_words.push_back(&postings);
+                if (compress_postings_) {
+                    postings.Compress(dense_inverse_word_counts_.data());
+                }
+            }
+            for (const auto& [dense_id, term_count] : word_postings) {
+                if (dense_id >= last_dense_id) {
+                    break;
+                }
+                if (postings.IsCompressed()) {
+                    postings.Append(dense_id, term_count, dense_inverse_word_counts_[dense_id]);
+                } else {
+                    postings.Insert(dense_id, term_count * dense_inverse_word_counts_[dense_id]);
+                }
+            }
+        }
+    }
+    for (PostingList* postings : changed_words) {
+        postings->RefreshLogDocumentFreq();
+    }
+    for (PostingList* postings : new_words) {
+        postings->SetInverseDocumentFreq(ComputeExactInverseDocumentFreq(*postings));
+    }
+    if (has_word_freqs_) {
+        for (size_t i = 0; i < valid_count; ++i) {
+            const TokenizedDocument& tokenized = tokenized_documents[i];
+            map<string_view, double>& stored_word_freqs = document_to_word_freqs_[documents[i].id];
+            for (const auto& [word, term_count] : tokenized.word_counts) {
+                stored_word_freqs.emplace_hint(stored_word_freqs.end(), word_to_document_freqs_.find(word)->first,
+                                               term_count * tokenized.inverse_word_count);
+            }
+        }
+    }
+    if (valid_count > 0) {
+        CountIndexMutations(static_cast<int>(valid_count));
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+void SearchServer::SetInverseDocumentFreqRefreshInterval(int mutation_count) {
+    if (mutation_count < 0) {
+        throw(invalid_argument("Refresh interval can't be negative"s));
+    }
+    idf_refresh_interval_ = mutation_count;
+    RefreshInverseDocumentFreqs();
+    ++generation_;
+}
+
+void SearchServer::SetPostingsCompression(bool enabled) {
+    compress_postings_ = enabled;
+    for (auto& [_, postings] : word_to_document_freqs_) {
+        if (enabled) {
+            postings.Compress(dense_inverse_word_counts_.data());
+        } else {
+            postings.Decompress(dense_inverse_word_counts_.data());
+        }
+    }
+    // A node per posting outweighs the compressed postings many times over.
+    if (enabled) {
+        lock_guard guard(*word_freqs_mutex_);
+        document_to_word_freqs_.clear();
+        has_word_freqs_ = false;
+    }
+}
+
+IndexStats SearchServer::GetIndexStats() const {
+    IndexStats stats;
+    stats.word_count = word_to_document_freqs_.size();
+    // Hash table nodes hold the key, the value and a link to the next node.
+    stats.memory_usage = word_to_document_freqs_.bucket_count() * sizeof(void*);
+    for (const auto& [word, postings] : word_to_document_freqs_) {
+        stats.posting_count += postings.size();
+        stats.memory_usage += sizeof(void*) + sizeof(string_view) + postings.GetMemoryUsage();
+    }
+    for (const string& word : words_storage_) {
+        stats.memory_usage += sizeof(string) + word.capacity();
+    }
+    // Tree nodes hold the color, three links and the element.
+    const size_t tree_node_size = 4 * sizeof(void*);
+    stats.memory_usage += document_to_dense_id_.size() * (tree_node_size + sizeof(pair<const int, int>));
+    stats.memory_usage += dense_document_ids_.capacity() * sizeof(int) + dense_ratings_.capacity() * sizeof(int)
+                          + dense_statuses_.capacity() * sizeof(DocumentStatus)
+                          + dense_inverse_word_counts_.capacity() * sizeof(double);
+    {
+        lock_guard guard(*word_freqs_mutex_);
+        for (const auto& [_, word_freqs] : document_to_word_freqs_) {
+            stats.forward_index_memory_usage += tree_node_size + sizeof(pair<const int, map<string_view, double>>)
+                                                + word_freqs.size() * (tree_node_size + sizeof(pair<const string_view, double>));
+        }
+    }
+    stats.memory_usage += stats.forward_index_memory_usage;
+    return stats;
+}
+
+const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
+    static const map<string_view, double> empty_word_freqs;
+    const auto& document_to_word_freqs = GetDocumentToWordFreqs();
+    const auto document_it = document_to_word_freqs.find(document_id);
+    if (document_it == document_to_word_freqs.end()) {
+        return empty_word_freqs;
+    }
+    return document_it->second;
+}
+
+void SearchServer::SaveSnapshot(const string& path) const {
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.stop_word_count = stop_words_.size();
+    header.document_count = GetDocumentCount();
+
+    vector<SnapshotString> stop_words;
+    string text_pool;
+    for (const string& word : stop_words_) {
+        stop_words.push_back({text_pool.size(), word.size()});
+        text_pool += word;
+    }
+    // Removed documents leave holes in dense ids, the snapshot numbers documents
+    // by their position in insertion order instead.
+    vector<SnapshotDocument> documents;
+    vector<int> snapshot_ids(dense_document_ids_.size(), INVALID_DOCUMENT_ID);
+    for (size_t dense_id = 0; dense_id < dense_document_ids_.size(); ++dense_id) {
+        const int document_id = dense_document_ids_[dense_id];
+        if (document_id == INVALID_DOCUMENT_ID) {
+            continue;
+        }
+        snapshot_ids[dense_id] = documents.size();
+        documents.push_back({document_id, dense_ratings_[dense_id], static_cast<int32_t>(dense_statuses_[dense_id]), 0,
+                             dense_inverse_word_counts_[dense_id]});
+    }
+    const bool has_holes = documents.size() != dense_document_ids_.size();
+    vector<SnapshotWord> words;
+    for (const auto& [word, postings] : word_to_document_freqs_) {
+        if (postings.empty()) {
+            continue;
+        }
+        words.push_back({{text_pool.size(), word.size()}, header.posting_count, postings.size(), postings.GetMaxTermFreq()});
+        text_pool += word;
+        header.posting_count += postings.size();
+    }
+    header.word_count = words.size();
+    header.text_pool_size = text_pool.size();
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        throw(runtime_error("Cannot open snapshot file "s + path));
+    }
+    const SnapshotLayout layout = ComputeSnapshotLayout(header);
+    WriteSnapshotSection(out, 0, &header, sizeof(header));
+    WriteSnapshotSection(out, layout.stop_words_offset, stop_words.data(), stop_words.size() * sizeof(SnapshotString));
+    WriteSnapshotSection(out, layout.documents_offset, documents.data(), documents.size() * sizeof(SnapshotDocument));
+    WriteSnapshotSection(out, layout.words_offset, words.data(), words.size() * sizeof(SnapshotWord));
+    out.seekp(layout.document_ids_offset);
+    vector<int> document_ids;
+    for (const SnapshotWord& word : words) {
+        const PostingList& postings = word_to_document_freqs_.at(GetSnapshotText(text_pool.data(), word.text));
+        const int* dense_ids = postings.GetDocumentIds();
+        if (has_holes || postings.IsCompressed()) {
+            document_ids.clear();
+            postings.ForEachPosting(dense_inverse_word_counts_.data(), [&](int dense_id, double) {
+                document_ids.push_back(has_holes ? snapshot_ids[dense_id] : dense_id);
+            });
+            dense_ids = document_ids.data();
+        }
+        out.write(reinterpret_cast<const char*>(dense_ids), postings.size() * sizeof(int));
+    }
+    out.seekp(layout.term_freqs_offset);
+    vector<double> term_freqs;
+    for (const SnapshotWord& word : words) {
+        const PostingList& postings = word_to_document_freqs_.at(GetSnapshotText(text_pool.data(), word.text));
+        const double* word_term_freqs = postings.GetTermFreqs();
+        if (postings.IsCompressed()) {
+            term_freqs.clear();
+            postings.ForEachPosting(dense_inverse_word_counts_.data(), [&](int, double term_freq) {
+                term_freqs.push_back(term_freq);
+            });
+            word_term_freqs = term_freqs.data();
+        }
+        out.write(reinterpret_cast<const char*>(word_term_freqs), postings.size() * sizeof(double));
+    }
+    WriteSnapshotSection(out, layout.text_pool_offset, text_pool.data(), text_pool.size());
+    if (!out) {
+        throw(runtime_error("Cannot write snapshot file "s + path));
+    }
+}
+
+SearchServer SearchServer::LoadSnapshot(const string& path, pmr::memory_resource* memory_resource) {
+    auto snapshot = make_shared<const MappedFile>(path);
+    const char* data = snapshot->GetData();
+    const size_t size = snapshot->GetSize();
+
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        throw(runtime_error("Snapshot file is too small"s));
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        throw(runtime_error("File is not a search server snapshot"s));
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        throw(runtime_error("Unsupported snapshot version "s + to_string(header.version)));
+    }
+    // Counts are bounded by the file size before the layout multiplies them, so that
+    // the section sizes can't overflow and wrap around to a size that fits the file.
+    if (header.stop_word_count > size / sizeof(SnapshotString) || header.document_count > size / sizeof(SnapshotDocument)
+        || header.document_count > static_cast<uint64_t>(numeric_limits<int>::max())
+        || header.word_count > size / sizeof(SnapshotWord) || header.posting_count > size / sizeof(double)
+        || header.text_pool_size > size) {
+        throw(runtime_error("Snapshot file is truncated"s));
+    }
+    const SnapshotLayout layout = ComputeSnapshotLayout(header);
+    if (layout.size > size) {
+        throw(runtime_error("Snapshot file is truncated"s));
+    }
+    const char* text_pool = data + layout.text_pool_offset;
+    const auto get_text = [&header, text_pool](const SnapshotString& text) {
+        if (text.offset > header.text_pool_size || text.size > header.text_pool_size - text.offset) {
+            throw(runtime_error("Snapshot word is out of text pool"s));
+        }
+        return GetSnapshotText(text_pool, text);
+    };
+
+    SearchServer server(memory_resource);
+    server.snapshot_ = snapshot;
+    const auto* stop_words = reinterpret_cast<const SnapshotString*>(data + layout.stop_words_offset);
+    for (uint64_t i = 0; i < header.stop_word_count; ++i) {
+        server.stop_words_.emplace(get_text(stop_words[i]));
+    }
+    const auto* documents = reinterpret_cast<const SnapshotDocument*>(data + layout.documents_offset);
+    server.dense_document_ids_.reserve(header.document_count);
+    server.dense_ratings_.reserve(header.document_count);
+    server.dense_statuses_.reserve(header.document_count);
+    server.dense_inverse_word_counts_.reserve(header.document_count);
+    for (uint64_t i = 0; i < header.document_count; ++i) {
+        const SnapshotDocument& document = documents[i];
+        if (document.status < 0 || document.status > static_cast<int32_t>(DocumentStatus::REMOVED)) {
+            throw(runtime_error("Invalid document status in snapshot"s));
+        }
+        if (document.id < 0 || !server.document_to_dense_id_.emplace(document.id, i).second) {
+            throw(runtime_error("Invalid document id in snapshot"s));
+        }
+        if (!(document.inverse_word_count > 0)) {
+            throw(runtime_error("Invalid document length in snapshot"s));
+        }
+        server.dense_document_ids_.push_back(document.id);
+        server.dense_ratings_.push_back(document.rating);
+        server.dense_statuses_.push_back(static_cast<DocumentStatus>(document.status));
+        server.document_columns_.Add(i, static_cast<DocumentStatus>(document.status), document.rating);
+        server.dense_inverse_word_counts_.push_back(document.inverse_word_count);
+    }
+    const auto* words = reinterpret_cast<const SnapshotWord*>(data + layout.words_offset);
+    const auto* document_ids = reinterpret_cast<const int*>(data + layout.document_ids_offset);
+    const auto* term_freqs = reinterpret_cast<const double*>(data + layout.term_freqs_offset);
+    server.word_to_document_freqs_.reserve(header.word_count);
+    for (uint64_t i = 0; i < header.word_count; ++i) {
+        const SnapshotWord& word = words[i];
+        if (word.first_posting > header.posting_count || word.posting_count > header.posting_count - word.first_posting) {
+            throw(runtime_error("Snapshot postings are out of range"s));
+        }
+        // Posting ids index document arrays, the lists check them on first use.
+        server.word_to_document_freqs_.emplace(
+            get_text(word.text),
+            PostingList::Borrow(document_ids + word.first_posting, term_freqs + word.first_posting, word.posting_count,
+                                word.max_term_freq, static_cast<int>(header.document_count)));
+    }
+    server.has_word_freqs_ = false;
+    server.UpdateLogDocumentCount();
+    return server;
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(string_view raw_query, int document_id) const {
+    return MatchDocument(execution::seq, raw_query, document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const execution::sequenced_policy&,
+                                                                       string_view raw_query, int document_id) const {
+    if (document_id < 0) {
+        throw(invalid_argument("Document ID cannot be negative"s));
+    }
+    QueryScratch scratch;
+    const Query query = ParseQuery(raw_query, scratch.GetResource());
+    const int dense_id = document_to_dense_id_.at(document_id);
+    const DocumentStatus status = dense_statuses_[dense_id];
+
+    for (const string_view word : query.minus_words) {
+        if (FindDocumentWord(word, dense_id) != nullptr) {
+            return {vector<string_view>(), status};
+        }
+    }
+    vector<string_view> matched_words;
+    for (const string_view word : query.plus_words) {
+        if (const string_view* document_word = FindDocumentWord(word, dense_id)) {
+            matched_words.push_back(*document_word);
+        }
+    }
+    return {matched_words, status};
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const execution::parallel_policy&,
+                                                                       string_view raw_query, int document_id) const {
+    if (document_id < 0) {
+        throw(invalid_argument("Document ID cannot be negative"s));
+    }
+    QueryScratch scratch;
+    const Query query = ParseQuery(raw_query, scratch.GetResource(), false);
+    CheckQueryPostings(query);
+    const int dense_id = document_to_dense_id_.at(document_id);
+    const DocumentStatus status = dense_statuses_[dense_id];
+
+    if (any_of(execution::par, query.minus_words.begin(), query.minus_words.end(), [this, dense_id](string_view word) {
+        return FindDocumentWord(word, dense_id) != nullptr;
+    })) {
+        return {vector<string_view>(), status};
+    }
+    // Words the document doesn't contain become empty and sort first.
+    vector<string_view> matched_words(query.plus_words.size());
+    transform(execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
+              [this, dense_id](string_view word) {
+                  const string_view* document_word = FindDocumentWord(word, dense_id);
+                  return document_word != nullptr ? *document_word : string_view();
+              });
+    sort(execution::par, matched_words.begin(), matched_words.end());
+    matched_words.erase(unique(matched_words.begin(), matched_words.end()), matched_words.end());
+    if (!matched_words.empty() && matched_words.front().empty()) {
+        matched_words.erase(matched_words.begin());
+    }
+    return {matched_words, status};
+}
+
+SearchServer::SnapshotLayout SearchServer::ComputeSnapshotLayout(const SnapshotHeader& header) {
+    const auto align = [](uint64_t offset) {
+        return (offset + 7) / 8 * 8;
+    };
+    SnapshotLayout layout;
+    layout.stop_words_offset = align(sizeof(SnapshotHeader));
+    layout.documents_offset = align(layout.stop_words_offset + header.stop_word_count * sizeof(SnapshotString));
+    layout.words_offset = align(layout.documents_offset + header.document_count * sizeof(SnapshotDocument));
+    layout.document_ids_offset = align(layout.words_offset + header.word_count * sizeof(SnapshotWord));
+    layout.term_freqs_offset = align(layout.document_ids_offset + header.posting_count * sizeof(int));
+    layout.text_pool_offset = align(layout.term_freqs_offset + header.posting_count * sizeof(double));
+    layout.size = layout.text_pool_offset + header.text_pool_size;
+    return layout;
+}
+
+DocumentSelection SearchServer::SelectDocuments(const DocumentFilter& filter, pmr::memory_resource* memory_resource) const {
+    pmr::vector<int> listed_dense_ids(memory_resource);
+    if (filter.document_ids) {
+        // Long lists are matched against the dense array of ids rather than looked
+        // up in the map one by one, which misses the cache on every node.
+        if (filter.document_ids->size() * 16 > document_to_dense_id_.size()) {
+            pmr::vector<int> document_ids(filter.document_ids->begin(), filter.document_ids->end(), memory_resource);
+            sort(document_ids.begin(), document_ids.end());
+            for (size_t dense_id = 0; dense_id < dense_document_ids_.size(); ++dense_id) {
+                const int document_id = dense_document_ids_[dense_id];
+                if (document_id != INVALID_DOCUMENT_ID && binary_search(document_ids.begin(), document_ids.end(), document_id)) {
+                    listed_dense_ids.push_back(dense_id);
+                }
+            }
+        } else {
+            for (const int document_id : *filter.document_ids) {
+                const auto dense_id_it = document_to_dense_id_.find(document_id);
+                if (dense_id_it != document_to_dense_id_.end()) {
+                    listed_dense_ids.push_back(dense_id_it->second);
+                }
+            }
+        }
+    }
+    return document_columns_.Select(filter, listed_dense_ids, memory_resource);
+}
+
+const map<int, map<string_view, double>>& SearchServer::GetDocumentToWordFreqs() const {
+    lock_guard guard(*word_freqs_mutex_);
+    if (!has_word_freqs_) {
+        for (const int document_id : *this) {
+            document_to_word_freqs_[document_id];
+        }
+        for (const auto& [word, postings] : word_to_document_freqs_) {
+            postings.ForEachPosting(dense_inverse_word_counts_.data(), [&, word = word](int dense_id, double term_freq) {
+                document_to_word_freqs_[dense_document_ids_[dense_id]].emplace(word, term_freq);
+            });
+        }
+        has_word_freqs_ = true;
+    }
+    return document_to_word_freqs_;
+}
+
+SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
+    bool is_minus = false;
+    // Word shouldn't be empty
+    if (text[0] == '-') {
+        is_minus = true;
+        text.remove_prefix(1);
+    }
+    if (text.empty() || text[0] == '-') {
+        throw(invalid_argument("Word can not be empty nor start with multiple minus signs"s));
+    }
+    return {text, is_minus, IsStopWord(text)};
+}
+
+SearchServer::Query SearchServer::ParseQuery(string_view text, pmr::memory_resource* memory_resource, bool deduplicate) const {
+    Query query(memory_resource);
+    pmr::vector<string_view> words(memory_resource);
+    SplitIntoWords(text, words);
+    query.plus_words.reserve(words.size());
+    for (const string_view word : words) {
+        QueryWord query_word = ParseQueryWord(word);
+        if (!query_word.is_stop) {
+            if (query_word.is_minus) {
+                query.minus_words.push_back(query_word.data);
+            } else {
+                query.plus_words.push_back(query_word.data);
+            }
+        }
+    }
+    if (deduplicate) {
+        SortUnique(query.plus_words);
+        SortUnique(query.minus_words);
+    }
+    return query;
+}
+
+string SearchServer::MakeQueryCacheKey(const Query& query, DocumentStatus status, size_t max_result_count, size_t offset) {
+    string key;
+    for (const string_view word : query.plus_words) {
+        key.append(word).push_back(' ');
+    }
+    for (const string_view word : query.minus_words) {
+        key.push_back('-');
+        key.append(word).push_back(' ');
+    }
+    key += to_string(static_cast<int>(status)) + ' ' + to_string(max_result_count) + ' ' + to_string(offset);
+    return key;
+}
+
+void SearchServer::RefreshInverseDocumentFreqs() {
+    mutations_since_idf_refresh_ = 0;
+    if (idf_refresh_interval_ == 0) {
+        return;
+    }
+    for (auto& [_, postings] : word_to_document_freqs_) {
+        postings.SetInverseDocumentFreq(ComputeExactInverseDocumentFreq(postings));
+    }
+}
+
+SearchServer::EvaluationBuffers& SearchServer::GetThreadEvaluationBuffers() {
+    thread_local EvaluationBuffers buffers;
+    return buffers;
+}
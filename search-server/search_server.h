@@ -0,0 +1,976 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+#include "document_columns.h"
+#include "mapped_file.h"
+#include "posting_list.h"
+#include "query_cache.h"
+#include "query_scratch.h"
+#include "relevance_accumulator.h"
+#include "string_processing.h"
+#include "top_document_candidates.h"
+
+using namespace std;
+
+const int MAX_RESULT_DOCUMENT_COUNT = 5;
+
+// Memory usage covers the postings, the words, the per-document arrays and
+// the forward index, which is also reported on its own.
+struct IndexStats {
+    size_t word_count = 0;
+    size_t posting_count = 0;
+    size_t memory_usage = 0;
+    size_t forward_index_memory_usage = 0;
+};
+
+// Relevance of every document containing a query word can be accumulated term
+// at a time, or posting lists can be merged document at a time keeping only
+// the top results, optionally skipping documents that can't reach them with WAND.
+enum class QueryEvaluation {
+    EXHAUSTIVE,
+    DOCUMENT_AT_A_TIME,
+    WAND,
+};
+
+struct QueryEvaluationStats {
+    uint64_t query_count = 0;
+    uint64_t scored_posting_count = 0;
+};
+
+class SearchServer {
+public:
+
+    inline static constexpr int INVALID_DOCUMENT_ID = -1;
+
+    SearchServer() : SearchServer(pmr::get_default_resource()) {}
+
+    // The index is allocated from the memory resource, which must outlive the server
+    // and its copies. Removing documents with a parallel policy allocates from
+    // several threads, then the resource must be thread-safe.
+    explicit SearchServer(pmr::memory_resource* memory_resource)
+        : word_to_document_freqs_(memory_resource),
+          document_to_dense_id_(memory_resource),
+          dense_document_ids_(memory_resource),
+          dense_ratings_(memory_resource),
+          dense_statuses_(memory_resource),
+          dense_inverse_word_counts_(memory_resource),
+          document_columns_(memory_resource) {}
+
+    SearchServer(const string& text, pmr::memory_resource* memory_resource = pmr::get_default_resource())
+        : SearchServer(string_view(text), memory_resource) {}
+
+    SearchServer(string_view text, pmr::memory_resource* memory_resource = pmr::get_default_resource())
+        : SearchServer(SplitIntoWords(text), memory_resource) {}
+
+    template<typename Container>
+    explicit SearchServer(const Container& stop_words, pmr::memory_resource* memory_resource = pmr::get_default_resource())
+        : SearchServer(memory_resource) {
+        for (const auto& word : stop_words) {
+            CheckIfWordIsValid(word);
+            if (!string_view(word).empty()) {
+                stop_words_.emplace(word);
+            }
+        }
+    }
+
+    // Index keys point into words_storage_, so copies re-intern every word.
+    // Postings borrowed from a snapshot keep pointing into the shared mapping.
+    // The copy uses the same memory resource.
+    SearchServer(const SearchServer& other);
+
+    SearchServer(SearchServer&&) = default;
+
+    SearchServer& operator=(const SearchServer& other);
+
+    SearchServer& operator=(SearchServer&&) = default;
+
+    void AddDocument(int document_id, string_view document, DocumentStatus status,
+                     const vector<int>& ratings);
+
+    // Adds documents as AddDocument would one by one: when a document is rejected,
+    // the documents before it are added and the error is rethrown. Documents are
+    // tokenized in parallel into postings of contiguous parts of the batch, which
+    // are then appended to the index once per word of every part.
+    void AddDocuments(const vector<NewDocument>& documents);
+
+    // Only postings of the document's own words are touched.
+    template<typename ExecutionPolicy>
+    void RemoveDocument(ExecutionPolicy&& policy, int document_id) {
+        const auto dense_id_it = document_to_dense_id_.find(document_id);
+        if (dense_id_it == document_to_dense_id_.end()) {
+            return;
+        }
+        const int dense_id = dense_id_it->second;
+        document_columns_.Remove(dense_id, dense_statuses_[dense_id]);
+        const auto document_it = GetDocumentToWordFreqs().find(document_id);
+        vector<PostingList*> postings_lists;
+        postings_lists.reserve(document_it->second.size());
+        for (const auto& [word, _] : document_it->second) {
+            postings_lists.push_back(&word_to_document_freqs_.at(word));
+            postings_lists.back()->CheckDocumentIds();
+        }
+        const double* inverse_word_counts = dense_inverse_word_counts_.data();
+        for_each(policy, postings_lists.begin(), postings_lists.end(), [dense_id, inverse_word_counts](PostingList* postings) {
+            if (postings->IsCompressed()) {
+                postings->Decompress(inverse_word_counts);
+                postings->Erase(dense_id);
+                postings->Compress(inverse_word_counts);
+            } else {
+                postings->Erase(dense_id);
+            }
+            postings->RefreshLogDocumentFreq();
+        });
+        document_to_word_freqs_.erase(document_it);
+        // The dense id isn't reused, no posting refers to it anymore.
+        dense_document_ids_[dense_id] = INVALID_DOCUMENT_ID;
+        document_to_dense_id_.erase(dense_id_it);
+        UpdateLogDocumentCount();
+        CountIndexMutation();
+    }
+
+    // By default IDF is exact after every change of the index. With a positive
+    // interval IDFs are recomputed once per mutation_count added or removed documents
+    // and may be stale in between, which saves work on corpora where it's acceptable.
+    void SetInverseDocumentFreqRefreshInterval(int mutation_count);
+
+    // Results of queries filtered by status are kept for the capacity most recent
+    // distinct queries, any change of the index invalidates them. Queries with
+    // a custom filter are never cached. Zero capacity disables the cache.
+    void EnableQueryCache(size_t capacity) {
+        query_cache_ = capacity == 0 ? nullptr : make_unique<QueryCache>(capacity);
+    }
+
+    QueryCacheStats GetQueryCacheStats() const {
+        return query_cache_ ? query_cache_->GetStats() : QueryCacheStats{};
+    }
+
+    // Compressed postings take several times less memory at the cost of decoding
+    // the query's postings on every search. Results don't change.
+    // Words added while compression is on are compressed too. Enabling compression
+    // drops the forward index, it's rebuilt from postings when first needed again.
+    void SetPostingsCompression(bool enabled);
+
+    void RemoveDocument(int document_id) {
+        RemoveDocument(execution::seq, document_id);
+    }
+
+    // Returns at most max_result_count documents starting from the given position
+    // of the ranking, so that a page of results is found without ranking the previous ones.
+    template<typename ExecutionPolicy, typename Filter>
+    vector<Document> FindTopDocuments(ExecutionPolicy&& policy, string_view raw_query, Filter filter,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT, size_t offset = 0) const {
+        QueryScratch scratch;
+        return FindTopDocuments(policy, ParseQuery(raw_query, scratch.GetResource()), filter, max_result_count, offset);
+    }
+
+    template<typename ExecutionPolicy>
+    vector<Document> FindTopDocuments(ExecutionPolicy&& policy, string_view raw_query, const DocumentStatus& status,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT, size_t offset = 0) const {
+        QueryScratch scratch;
+        const Query query = ParseQuery(raw_query, scratch.GetResource());
+        DocumentFilter status_filter;
+        status_filter.status = status;
+        if (!query_cache_) {
+            return FindTopDocuments(policy, query, status_filter, max_result_count, offset);
+        }
+        const string key = MakeQueryCacheKey(query, status, max_result_count, offset);
+        if (optional<vector<Document>> documents = query_cache_->Find(key, generation_)) {
+            return move(*documents);
+        }
+        vector<Document> documents = FindTopDocuments(policy, query, status_filter, max_result_count, offset);
+        query_cache_->Insert(key, generation_, documents);
+        return documents;
+    }
+
+    // Conditions of the filter are evaluated on bitsets of documents, so no predicate
+    // is called. Document-at-a-time and WAND evaluation skip documents failing them
+    // before scoring; exhaustive evaluation scores every posting and drops them from
+    // the accumulated relevances before the results are collected.
+    template<typename ExecutionPolicy>
+    vector<Document> FindTopDocuments(ExecutionPolicy&& policy, string_view raw_query, const DocumentFilter& filter,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT, size_t offset = 0) const {
+        QueryScratch scratch;
+        return FindTopDocuments(policy, ParseQuery(raw_query, scratch.GetResource()), filter, max_result_count, offset);
+    }
+
+    template<typename ExecutionPolicy>
+    vector<Document> FindTopDocuments(ExecutionPolicy&& policy, string_view raw_query) const {
+        return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+    }
+
+    template<typename Filter>
+    vector<Document> FindTopDocuments(string_view raw_query, Filter filter,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT, size_t offset = 0) const {
+        return FindTopDocuments(execution::seq, raw_query, filter, max_result_count, offset);
+    }
+
+    vector<Document> FindTopDocuments(string_view raw_query, const DocumentStatus& status,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT, size_t offset = 0) const {
+        return FindTopDocuments(execution::seq, raw_query, status, max_result_count, offset);
+    }
+
+    vector<Document> FindTopDocuments(string_view raw_query, const DocumentFilter& filter,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT, size_t offset = 0) const {
+        return FindTopDocuments(execution::seq, raw_query, filter, max_result_count, offset);
+    }
+
+    vector<Document> FindTopDocuments(string_view raw_query) const {
+        return FindTopDocuments(execution::seq, raw_query);
+    }
+
+    int GetDocumentCount() const {
+        return document_to_dense_id_.size();
+    }
+
+    pmr::memory_resource* GetMemoryResource() const {
+        return document_to_dense_id_.get_allocator().resource();
+    }
+
+    IndexStats GetIndexStats() const;
+
+    // Document-at-a-time evaluation takes memory proportional to the number of
+    // requested results instead of the number of matched documents. WAND bounds
+    // the relevance a document may get from every word by the word's largest term
+    // frequency, and scores a document only if the bounds of the words it may
+    // contain reach the relevance of the current top results. Rankings don't
+    // change. Searches with a parallel policy are always exhaustive.
+    void SetQueryEvaluation(QueryEvaluation evaluation) {
+        query_evaluation_ = evaluation;
+    }
+
+    // Counts searches and postings scored by them since the server was created.
+    QueryEvaluationStats GetQueryEvaluationStats() const {
+        return {evaluation_counters_->query_count.load(), evaluation_counters_->scored_posting_count.load()};
+    }
+
+    // Dense ids are given in insertion order, so documents are iterated over
+    // their slots, skipping the ones of removed documents.
+    class DocumentIdIterator {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = int;
+        using difference_type = ptrdiff_t;
+        using pointer = const int*;
+        using reference = const int&;
+
+        DocumentIdIterator(const int* position, const int* end) : position_(position), end_(end) {
+            SkipRemoved();
+        }
+
+        reference operator*() const {
+            return *position_;
+        }
+
+        DocumentIdIterator& operator++() {
+            ++position_;
+            SkipRemoved();
+            return *this;
+        }
+
+        DocumentIdIterator operator++(int) {
+            DocumentIdIterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const DocumentIdIterator& other) const {
+            return position_ == other.position_;
+        }
+
+        bool operator!=(const DocumentIdIterator& other) const {
+            return position_ != other.position_;
+        }
+
+    private:
+        const int* position_;
+        const int* end_;
+
+        void SkipRemoved() {
+            while (position_ != end_ && *position_ == INVALID_DOCUMENT_ID) {
+                ++position_;
+            }
+        }
+    };
+
+    // Iterates over document ids in insertion order.
+    DocumentIdIterator begin() const {
+        const int* end = dense_document_ids_.data() + dense_document_ids_.size();
+        return {dense_document_ids_.data(), end};
+    }
+
+    DocumentIdIterator end() const {
+        const int* end = dense_document_ids_.data() + dense_document_ids_.size();
+        return {end, end};
+    }
+
+    const map<string_view, double>& GetWordFrequencies(int document_id) const;
+
+    // Writes the index in a binary format that LoadSnapshot maps back into memory.
+    void SaveSnapshot(const string& path) const;
+
+    // Maps a snapshot written by SaveSnapshot. Words and postings are used right from
+    // the mapped file, only documents' data is copied, so loading doesn't depend on
+    // the number of postings. The forward index is built on first use.
+    static SearchServer LoadSnapshot(const string& path, pmr::memory_resource* memory_resource = pmr::get_default_resource());
+
+    const set<string, less<>>& GetStopWords() const {
+        return stop_words_;
+    }
+
+    // Takes a walk over the slots of removed documents once there are any.
+    int GetDocumentId(int index) const {
+        if (index < 0 || index >= GetDocumentCount()) {
+            throw(out_of_range("Document index is out of range"s));
+        }
+        if (dense_document_ids_.size() == document_to_dense_id_.size()) {
+            return dense_document_ids_[index];
+        }
+        return *next(begin(), index);
+    }
+
+    // Matched words point into the index and stay valid while the server lives.
+    // No words match when the document contains a minus word.
+    tuple<vector<string_view>, DocumentStatus> MatchDocument(string_view raw_query, int document_id) const;
+
+    tuple<vector<string_view>, DocumentStatus> MatchDocument(const execution::sequenced_policy&, string_view raw_query,
+                                                             int document_id) const;
+
+    // Plus words are looked up in parallel, repeated ones are dropped from the result.
+    tuple<vector<string_view>, DocumentStatus> MatchDocument(const execution::parallel_policy&, string_view raw_query,
+                                                             int document_id) const;
+
+private:
+    // Shards are searched with IDFs of the whole corpus passed in the query.
+    friend class ShardedSearchServer;
+    // Query parsing is benchmarked on its own.
+    friend class ParseQueryBenchmark;
+
+    set<string, less<>> stop_words_;
+    // Owns the single copy of every indexed word, elements never move. It stays
+    // on the global heap: containers of different memory resources move elements
+    // one by one on assignment, which would leave index keys dangling.
+    // Words stay in the index with empty postings after their documents are removed.
+    deque<string> words_storage_;
+    // Postings refer to documents by dense ids, positions in the arrays below.
+    pmr::unordered_map<string_view, PostingList> word_to_document_freqs_;
+    pmr::map<int, int> document_to_dense_id_;
+    // Removed documents keep their slots with INVALID_DOCUMENT_ID.
+    pmr::vector<int> dense_document_ids_;
+    pmr::vector<int> dense_ratings_;
+    pmr::vector<DocumentStatus> dense_statuses_;
+    // Compressed postings recover term frequencies from these.
+    pmr::vector<double> dense_inverse_word_counts_;
+    DocumentColumns document_columns_;
+    // Forward index, a loaded snapshot or a compressed index doesn't have it until it's first needed.
+    mutable map<int, map<string_view, double>> document_to_word_freqs_;
+    mutable bool has_word_freqs_ = true;
+    mutable unique_ptr<mutex> word_freqs_mutex_ = make_unique<mutex>();
+    // Mapped snapshot file, words and postings of a loaded snapshot point into it.
+    shared_ptr<const MappedFile> snapshot_;
+    double log_document_count_ = 0;
+    int idf_refresh_interval_ = 0;
+    int mutations_since_idf_refresh_ = 0;
+    // Bumped by every change of the index that may change search results.
+    uint64_t generation_ = 0;
+    unique_ptr<QueryCache> query_cache_;
+    bool compress_postings_ = false;
+    QueryEvaluation query_evaluation_ = QueryEvaluation::EXHAUSTIVE;
+    struct QueryEvaluationCounters {
+        atomic<uint64_t> query_count = 0;
+        atomic<uint64_t> scored_posting_count = 0;
+    };
+    mutable unique_ptr<QueryEvaluationCounters> evaluation_counters_ = make_unique<QueryEvaluationCounters>();
+
+    inline static constexpr char SNAPSHOT_MAGIC[8] = {'S', 'R', 'C', 'H', 'S', 'N', 'A', 'P'};
+    inline static constexpr uint32_t SNAPSHOT_VERSION = 4;
+
+    // Snapshot file: header, stop words, documents in insertion order, words,
+    // document ids and term frequencies of all postings, text of all words.
+    // Posting document ids are positions in the documents section.
+    // Sections are aligned to 8 bytes, numbers use the native byte order.
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t stop_word_count;
+        uint64_t document_count;
+        uint64_t word_count;
+        uint64_t posting_count = 0;
+        uint64_t text_pool_size;
+    };
+
+    struct SnapshotString {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct SnapshotDocument {
+        int32_t id;
+        int32_t rating;
+        int32_t status;
+        int32_t reserved;
+        double inverse_word_count;
+    };
+
+    struct SnapshotWord {
+        SnapshotString text;
+        uint64_t first_posting;
+        uint64_t posting_count;
+        double max_term_freq;
+    };
+
+    struct SnapshotLayout {
+        uint64_t stop_words_offset;
+        uint64_t documents_offset;
+        uint64_t words_offset;
+        uint64_t document_ids_offset;
+        uint64_t term_freqs_offset;
+        uint64_t text_pool_offset;
+        uint64_t size;
+    };
+
+    static_assert(sizeof(int) == sizeof(int32_t), "Snapshot stores document ids as 32-bit integers");
+
+    static SnapshotLayout ComputeSnapshotLayout(const SnapshotHeader& header);
+
+    static void WriteSnapshotSection(ostream& out, uint64_t offset, const void* data, size_t size) {
+        out.seekp(offset);
+        out.write(static_cast<const char*>(data), size);
+    }
+
+    static string_view GetSnapshotText(const char* text_pool, const SnapshotString& text) {
+        return {text_pool + text.offset, text.size};
+    }
+
+    const map<int, map<string_view, double>>& GetDocumentToWordFreqs() const;
+
+    bool IsStopWord(string_view word) const {
+        return stop_words_.count(word) > 0;
+    }
+
+    vector<string_view> SplitIntoWordsNoStop(string_view text) const {
+        vector<string_view> words = SplitIntoWords(text);
+        words.erase(remove_if(words.begin(), words.end(), [this](string_view word) {
+            return IsStopWord(word);
+        }), words.end());
+        return words;
+    }
+
+    pair<const string_view, PostingList>& GetOrAddWord(string_view word) {
+        const auto word_it = word_to_document_freqs_.find(word);
+        if (word_it != word_to_document_freqs_.end()) {
+            return *word_it;
+        }
+        return *word_to_document_freqs_.emplace(words_storage_.emplace_back(word), PostingList()).first;
+    }
+
+    // Returns nullptr when no document contains the word.
+    const PostingList* FindPostings(string_view word) const {
+        const auto word_it = word_to_document_freqs_.find(word);
+        if (word_it == word_to_document_freqs_.end() || word_it->second.empty()) {
+            return nullptr;
+        }
+        return &word_it->second;
+    }
+
+    // Returns the index's copy of the word if the document contains it, nullptr otherwise.
+    const string_view* FindDocumentWord(string_view word, int dense_id) const {
+        const auto word_it = word_to_document_freqs_.find(word);
+        if (word_it == word_to_document_freqs_.end() || !word_it->second.Contains(dense_id)) {
+            return nullptr;
+        }
+        return &word_it->first;
+    }
+
+    void CheckNewDocumentId(int document_id) const {
+        if (document_id < 0 || document_to_dense_id_.count(document_id) != 0) {
+            throw(invalid_argument("Document id can't be negative nor be equal to already added documents"s));
+        }
+    }
+
+    static int ComputeAverageRating(const vector<int>& ratings) {
+        if (ratings.empty()) {
+            return 0;
+        }
+        int rating_sum = 0;
+        for (const int rating : ratings) {
+            rating_sum += rating;
+        }
+        return rating_sum / static_cast<int>(ratings.size());
+    }
+
+    struct QueryWord {
+        string_view data;
+        bool is_minus;
+        bool is_stop;
+    };
+
+    QueryWord ParseQueryWord(string_view text) const;
+
+        // Words are kept sorted and unique, vectors allow parallel traversal.
+        // Words point into the raw query text.
+        struct Query {
+            explicit Query(pmr::memory_resource* memory_resource)
+                : plus_words(memory_resource), minus_words(memory_resource), inverse_document_freqs(memory_resource) {}
+
+            pmr::vector<string_view> plus_words;
+            pmr::vector<string_view> minus_words;
+            // IDFs of plus words computed outside of the server, empty to use the server's own.
+            pmr::vector<double> inverse_document_freqs;
+        };
+
+        template<typename Words>
+        static void SortUnique(Words& words) {
+            sort(words.begin(), words.end());
+            words.erase(unique(words.begin(), words.end()), words.end());
+        }
+
+        // The query and its temporaries are allocated from the memory resource.
+        // Without deduplication words keep their order and repeats, for callers
+        // which are cheaper to deduplicate their own results.
+        Query ParseQuery(string_view text, pmr::memory_resource* memory_resource, bool deduplicate = true) const;
+
+        // Postings of a loaded snapshot are checked on first access, which throws if
+        // the file is damaged. Parallel algorithms terminate on escaping exceptions,
+        // so postings of the query's words are checked before them.
+        void CheckQueryPostings(const Query& query) const {
+            if (!snapshot_) {
+                return;
+            }
+            for (const auto* words : {&query.plus_words, &query.minus_words}) {
+                for (const string_view word : *words) {
+                    if (const PostingList* postings = FindPostings(word)) {
+                        postings->CheckDocumentIds();
+                    }
+                }
+            }
+        }
+
+        template<typename ExecutionPolicy, typename Filter>
+        vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const Query& query, Filter filter,
+                                          size_t max_result_count, size_t offset) const {
+            return FindSelectedTopDocuments(policy, query, DocumentSelection{}, filter, max_result_count, offset);
+        }
+
+        template<typename ExecutionPolicy>
+        vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const Query& query, const DocumentFilter& filter,
+                                          size_t max_result_count, size_t offset) const {
+            QueryScratch scratch;
+            const DocumentSelection selection = SelectDocuments(filter, scratch.GetResource());
+            const auto accept_all = [](int document_id, DocumentStatus status, int rating) {
+                return true;
+            };
+            return FindSelectedTopDocuments(policy, query, selection, accept_all, max_result_count, offset);
+        }
+
+        // Documents outside of the selection are dropped before the filter is called.
+        DocumentSelection SelectDocuments(const DocumentFilter& filter, pmr::memory_resource* memory_resource) const;
+
+        template<typename ExecutionPolicy, typename Filter>
+        vector<Document> FindSelectedTopDocuments(ExecutionPolicy&& policy, const Query& query,
+                                                  const DocumentSelection& selection, Filter filter,
+                                                  size_t max_result_count, size_t offset) const {
+            QueryScratch scratch;
+            const QueryEvaluation evaluation = is_same_v<decay_t<ExecutionPolicy>, execution::sequenced_policy>
+                                               ? query_evaluation_ : QueryEvaluation::EXHAUSTIVE;
+            const size_t top_count = max_result_count > numeric_limits<size_t>::max() - offset
+                                     ? numeric_limits<size_t>::max() : offset + max_result_count;
+            pmr::vector<Document> matched_documents(scratch.GetResource());
+            switch (evaluation) {
+                case QueryEvaluation::EXHAUSTIVE:
+                    matched_documents = FindAllDocuments(policy, query, selection, filter, scratch.GetResource());
+                    break;
+                case QueryEvaluation::DOCUMENT_AT_A_TIME:
+                    matched_documents = FindTopDocumentCandidates(query, selection, filter, top_count,
+                                                                  scratch.GetResource());
+                    break;
+                case QueryEvaluation::WAND:
+                    matched_documents = FindWandTopDocumentCandidates(query, selection, filter, top_count,
+                                                                      scratch.GetResource());
+                    break;
+            }
+            if (offset >= matched_documents.size()) {
+                return {};
+            }
+            const auto first = matched_documents.begin() + offset;
+            const auto last = first + min(max_result_count, matched_documents.size() - offset);
+
+            // Documents before the offset are only separated from the rest, not ordered,
+            // and only the requested documents are ordered among the remaining ones.
+            if (offset > 0) {
+                nth_element(policy, matched_documents.begin(), first, matched_documents.end(), CompareDocumentsByRelevance);
+            }
+            partial_sort(policy, first, last, matched_documents.end(), CompareDocumentsByRelevance);
+            return {first, last};
+        }
+
+        // Queries differing only in word order, repeated or stop words share a key.
+        static string MakeQueryCacheKey(const Query& query, DocumentStatus status, size_t max_result_count, size_t offset);
+
+        double ComputeExactInverseDocumentFreq(const PostingList& postings) const {
+            return log_document_count_ - postings.GetLogDocumentFreq();
+        }
+
+        double ComputeWordInverseDocumentFreq(const PostingList& postings) const {
+            if (idf_refresh_interval_ > 0) {
+                return postings.GetInverseDocumentFreq();
+            }
+            return ComputeExactInverseDocumentFreq(postings);
+        }
+
+        double ComputeQueryWordInverseDocumentFreq(const Query& query, size_t plus_word_index,
+                                                   const PostingList& postings) const {
+            if (!query.inverse_document_freqs.empty()) {
+                return query.inverse_document_freqs[plus_word_index];
+            }
+            return ComputeWordInverseDocumentFreq(postings);
+        }
+
+        void UpdateLogDocumentCount() {
+            log_document_count_ = document_to_dense_id_.empty() ? 0 : log(static_cast<double>(document_to_dense_id_.size()));
+        }
+
+        void CountIndexMutation() {
+            CountIndexMutations(1);
+        }
+
+        // A batch is one change of the index: the generation moves once and IDFs
+        // are refreshed at most once, however many documents it added.
+        void CountIndexMutations(int mutation_count) {
+            ++generation_;
+            if (idf_refresh_interval_ > 0) {
+                mutations_since_idf_refresh_ += mutation_count;
+                if (mutations_since_idf_refresh_ >= idf_refresh_interval_) {
+                    RefreshInverseDocumentFreqs();
+                }
+            }
+        }
+
+        void RefreshInverseDocumentFreqs();
+
+        // Buffers grow to the number of dense ids and are reused by later queries.
+        // A single set per thread serves every filter type and execution policy.
+        struct EvaluationBuffers {
+            RelevanceAccumulator accumulator;
+        };
+
+        static EvaluationBuffers& GetThreadEvaluationBuffers();
+
+        // Adds the postings with ids in [first_id, last_id) and returns their number.
+        // Compressed postings are decoded and added a block at a time, so a query
+        // takes no memory proportional to the number of its postings.
+        size_t AccumulatePlusWord(RelevanceAccumulator& accumulator, const PostingList& postings,
+                                  double inverse_document_freq, int first_id, int last_id) const {
+            size_t posting_count = 0;
+            const bool is_compressed = postings.IsCompressed();
+            postings.ForEachPostingRun(dense_inverse_word_counts_.data(), first_id, last_id,
+                                       [&](const int* document_ids, const double* term_freqs, size_t size) {
+                if (is_compressed) {
+                    accumulator.AddTransient(document_ids, term_freqs, size, inverse_document_freq, first_id);
+                } else {
+                    accumulator.Add(document_ids, term_freqs, size, inverse_document_freq, first_id);
+                }
+                posting_count += size;
+            });
+            return posting_count;
+        }
+
+        void AccumulateMinusWord(RelevanceAccumulator& accumulator, const PostingList& postings,
+                                 int first_id, int last_id) const {
+            postings.ForEachPostingRun(dense_inverse_word_counts_.data(), first_id, last_id,
+                                       [&](const int* document_ids, const double*, size_t size) {
+                accumulator.Exclude(document_ids, size, first_id);
+            });
+        }
+
+        // Relevance is accumulated in a thread-local array indexed by dense ids.
+        // The filter is applied once per matched document, not per posting.
+        template<typename Filter>
+        pmr::vector<Document> FindAllDocuments(const execution::sequenced_policy&, const Query& query,
+                                               const DocumentSelection& selection, Filter filter,
+                                               pmr::memory_resource* memory_resource) const {
+            // Damaged snapshot postings throw here, before any word is accumulated.
+            CheckQueryPostings(query);
+            RelevanceAccumulator& accumulator = GetThreadEvaluationBuffers().accumulator;
+            accumulator.Reset(dense_document_ids_.size());
+            const int dense_id_count = dense_document_ids_.size();
+            for (const string_view word : query.minus_words) {
+                if (const PostingList* postings = FindPostings(word)) {
+                    AccumulateMinusWord(accumulator, *postings, 0, dense_id_count);
+                }
+            }
+            size_t scored_posting_count = 0;
+            for (size_t i = 0; i < query.plus_words.size(); ++i) {
+                if (const PostingList* postings = FindPostings(query.plus_words[i])) {
+                    scored_posting_count += AccumulatePlusWord(accumulator, *postings,
+                                                               ComputeQueryWordInverseDocumentFreq(query, i, *postings),
+                                                               0, dense_id_count);
+                }
+            }
+            CountEvaluatedQuery(scored_posting_count);
+            // Postings are scored without consulting the selection, which keeps the
+            // kernels branch-free; unselected documents are cleared afterwards.
+            if (selection.bits != nullptr) {
+                accumulator.Restrict(selection.bits, selection.word_count, 0);
+            }
+            pmr::vector<Document> matched_documents(memory_resource);
+            AppendMatchedDocuments(accumulator, 0, filter, matched_documents);
+            return matched_documents;
+        }
+
+        // Documents are split into ranges of dense ids, each range is scored
+        // independently from the part of every posting list that falls into it.
+        template<typename Filter>
+        pmr::vector<Document> FindAllDocuments(const execution::parallel_policy&, const Query& query,
+                                               const DocumentSelection& selection, Filter filter,
+                                               pmr::memory_resource* memory_resource) const {
+            struct WordPostings {
+                const PostingList* postings;
+                double inverse_document_freq;
+            };
+            CheckQueryPostings(query);
+            vector<WordPostings> plus_postings;
+            vector<WordPostings> minus_postings;
+            size_t scored_posting_count = 0;
+            for (size_t i = 0; i < query.plus_words.size(); ++i) {
+                if (const PostingList* postings = FindPostings(query.plus_words[i])) {
+                    plus_postings.push_back({postings, ComputeQueryWordInverseDocumentFreq(query, i, *postings)});
+                    scored_posting_count += postings->size();
+                }
+            }
+            CountEvaluatedQuery(scored_posting_count);
+            for (const string_view word : query.minus_words) {
+                if (const PostingList* postings = FindPostings(word)) {
+                    minus_postings.push_back({postings, 0});
+                }
+            }
+
+            const int dense_id_count = dense_document_ids_.size();
+            const int shard_count = min(dense_id_count, static_cast<int>(max(1u, thread::hardware_concurrency())) * 4);
+            vector<vector<Document>> shard_documents(shard_count);
+            vector<int> shards(shard_count);
+            iota(shards.begin(), shards.end(), 0);
+            for_each(execution::par, shards.begin(), shards.end(), [&](int shard) {
+                const int first_id = static_cast<int64_t>(dense_id_count) * shard / shard_count;
+                const int last_id = static_cast<int64_t>(dense_id_count) * (shard + 1) / shard_count;
+                RelevanceAccumulator& accumulator = GetThreadEvaluationBuffers().accumulator;
+                accumulator.Reset(last_id - first_id);
+                for (const WordPostings& word : minus_postings) {
+                    AccumulateMinusWord(accumulator, *word.postings, first_id, last_id);
+                }
+                for (const WordPostings& word : plus_postings) {
+                    AccumulatePlusWord(accumulator, *word.postings, word.inverse_document_freq, first_id, last_id);
+                }
+                if (selection.bits != nullptr) {
+                    accumulator.Restrict(selection.bits, selection.word_count, first_id);
+                }
+                AppendMatchedDocuments(accumulator, first_id, filter, shard_documents[shard]);
+            });
+
+            // Shards run on other threads, only the caller's thread allocates from its scratch.
+            pmr::vector<Document> matched_documents(memory_resource);
+            for (vector<Document>& documents : shard_documents) {
+                matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+            }
+            return matched_documents;
+        }
+
+        struct PlusWordCursor {
+            PostingList::Cursor postings;
+            double inverse_document_freq;
+            double max_relevance;
+        };
+
+        // Cursors over the plus words' postings in the order of plus words, which
+        // is the order relevance is summed in by every evaluator. Returns false
+        // if a word's IDF is negative, then the words' bounds don't hold.
+        bool MakePlusWordCursors(const Query& query, pmr::vector<PlusWordCursor>& cursors) const {
+            bool are_bounds_valid = true;
+            for (size_t i = 0; i < query.plus_words.size(); ++i) {
+                const PostingList* postings = FindPostings(query.plus_words[i]);
+                if (postings == nullptr) {
+                    continue;
+                }
+                const double inverse_document_freq = ComputeQueryWordInverseDocumentFreq(query, i, *postings);
+                are_bounds_valid = are_bounds_valid && inverse_document_freq >= 0;
+                cursors.push_back({PostingList::Cursor(*postings, dense_inverse_word_counts_.data()),
+                                   inverse_document_freq, postings->GetMaxTermFreq() * inverse_document_freq});
+            }
+            return are_bounds_valid;
+        }
+
+        pmr::vector<PostingList::Cursor> MakeMinusWordCursors(const Query& query,
+                                                              pmr::memory_resource* memory_resource) const {
+            pmr::vector<PostingList::Cursor> cursors(memory_resource);
+            for (const string_view word : query.minus_words) {
+                if (const PostingList* postings = FindPostings(word)) {
+                    cursors.emplace_back(*postings, dense_inverse_word_counts_.data());
+                }
+            }
+            return cursors;
+        }
+
+        static bool ContainsMinusWord(pmr::vector<PostingList::Cursor>& minus_cursors, int dense_id) {
+            bool is_excluded = false;
+            for (PostingList::Cursor& cursor : minus_cursors) {
+                cursor.SkipTo(dense_id);
+                is_excluded = is_excluded || cursor.GetDocumentId() == dense_id;
+            }
+            return is_excluded;
+        }
+
+        // Sums relevance of the document from the cursors standing at it, in the order of cursors.
+        static double ComputeRelevance(const pmr::vector<PlusWordCursor>& cursors, int dense_id,
+                                       size_t& scored_posting_count) {
+            double relevance = 0;
+            for (const PlusWordCursor& cursor : cursors) {
+                if (cursor.postings.GetDocumentId() == dense_id) {
+                    relevance += cursor.postings.GetTermFreq() * cursor.inverse_document_freq;
+                    ++scored_posting_count;
+                }
+            }
+            return relevance;
+        }
+
+        // Document-at-a-time evaluation. Cursors over the plus words' postings are
+        // merged by document id, minus words' cursors skip ahead to the merged
+        // document, and the filter is applied before the document is scored.
+        // Only candidates for the top_count best documents are kept.
+        template<typename Filter>
+        pmr::vector<Document> FindTopDocumentCandidates(const Query& query, const DocumentSelection& selection,
+                                                        Filter filter, size_t top_count,
+                                                        pmr::memory_resource* memory_resource) const {
+            pmr::vector<PlusWordCursor> cursors(memory_resource);
+            MakePlusWordCursors(query, cursors);
+            pmr::vector<PostingList::Cursor> minus_cursors = MakeMinusWordCursors(query, memory_resource);
+            TopDocumentCandidates candidates(top_count, memory_resource);
+            size_t scored_posting_count = 0;
+            while (top_count > 0) {
+                int dense_id = numeric_limits<int>::max();
+                for (const PlusWordCursor& cursor : cursors) {
+                    dense_id = min(dense_id, cursor.postings.GetDocumentId());
+                }
+                if (dense_id == numeric_limits<int>::max()) {
+                    break;
+                }
+                const int document_id = dense_document_ids_[dense_id];
+                if (selection.Contains(dense_id) && !ContainsMinusWord(minus_cursors, dense_id)
+                    && filter(document_id, dense_statuses_[dense_id], dense_ratings_[dense_id])) {
+                    const double relevance = ComputeRelevance(cursors, dense_id, scored_posting_count);
+                    candidates.Add({document_id, relevance, dense_ratings_[dense_id]});
+                }
+                for (PlusWordCursor& cursor : cursors) {
+                    if (cursor.postings.GetDocumentId() == dense_id) {
+                        cursor.postings.Next();
+                    }
+                }
+            }
+            CountEvaluatedQuery(scored_posting_count);
+            return candidates.Extract();
+        }
+
+        // Document-at-a-time WAND. Cursors over the plus words' postings are ordered
+        // by their current documents. The pivot is the first cursor at which the sum
+        // of relevance bounds of the cursors up to it reaches the threshold: documents
+        // before the pivot's one appear only in the preceding cursors and can't reach it.
+        template<typename Filter>
+        pmr::vector<Document> FindWandTopDocumentCandidates(const Query& query, const DocumentSelection& selection,
+                                                            Filter filter, size_t top_count,
+                                                            pmr::memory_resource* memory_resource) const {
+            pmr::vector<PlusWordCursor> cursors(memory_resource);
+            if (!MakePlusWordCursors(query, cursors)) {
+                return FindTopDocumentCandidates(query, selection, filter, top_count, memory_resource);
+            }
+            pmr::vector<PostingList::Cursor> minus_cursors = MakeMinusWordCursors(query, memory_resource);
+            pmr::vector<PlusWordCursor*> ordered_cursors(memory_resource);
+            for (PlusWordCursor& cursor : cursors) {
+                ordered_cursors.push_back(&cursor);
+            }
+            const auto current_id = [](const PlusWordCursor* cursor) {
+                return cursor->postings.GetDocumentId();
+            };
+            TopDocumentCandidates candidates(top_count, memory_resource);
+            size_t scored_posting_count = 0;
+            while (top_count > 0) {
+                sort(ordered_cursors.begin(), ordered_cursors.end(), [&current_id](const PlusWordCursor* lhs,
+                                                                                   const PlusWordCursor* rhs) {
+                    return current_id(lhs) < current_id(rhs);
+                });
+                size_t pivot = 0;
+                double max_relevance = 0;
+                for (; pivot < ordered_cursors.size(); ++pivot) {
+                    max_relevance += ordered_cursors[pivot]->max_relevance;
+                    if (max_relevance >= candidates.GetThreshold()) {
+                        break;
+                    }
+                }
+                if (pivot == ordered_cursors.size() || current_id(ordered_cursors[pivot]) == numeric_limits<int>::max()) {
+                    break;
+                }
+                const int pivot_id = current_id(ordered_cursors[pivot]);
+                if (current_id(ordered_cursors[0]) != pivot_id) {
+                    for (size_t i = 0; i < pivot; ++i) {
+                        ordered_cursors[i]->postings.SkipTo(pivot_id);
+                    }
+                    continue;
+                }
+
+                const int document_id = dense_document_ids_[pivot_id];
+                if (selection.Contains(pivot_id) && !ContainsMinusWord(minus_cursors, pivot_id)
+                    && filter(document_id, dense_statuses_[pivot_id], dense_ratings_[pivot_id])) {
+                    const double relevance = ComputeRelevance(cursors, pivot_id, scored_posting_count);
+                    candidates.Add({document_id, relevance, dense_ratings_[pivot_id]});
+                }
+                for (PlusWordCursor* cursor : ordered_cursors) {
+                    if (current_id(cursor) != pivot_id) {
+                        break;
+                    }
+                    cursor->postings.Next();
+                }
+            }
+            CountEvaluatedQuery(scored_posting_count);
+            return candidates.Extract();
+        }
+
+        void CountEvaluatedQuery(size_t scored_posting_count) const {
+            evaluation_counters_->query_count.fetch_add(1, memory_order_relaxed);
+            evaluation_counters_->scored_posting_count.fetch_add(scored_posting_count, memory_order_relaxed);
+        }
+
+        // External ids are looked up only for documents that matched the query.
+        template<typename Filter, typename Documents>
+        void AppendMatchedDocuments(RelevanceAccumulator& accumulator, int first_dense_id, Filter& filter,
+                                    Documents& matched_documents) const {
+            accumulator.ExtractMatched([&](int id, double relevance) {
+                const int dense_id = first_dense_id + id;
+                const int document_id = dense_document_ids_[dense_id];
+                if (filter(document_id, dense_statuses_[dense_id], dense_ratings_[dense_id])) {
+                    matched_documents.push_back({document_id, relevance, dense_ratings_[dense_id]});
+                }
+            });
+        }
+    };
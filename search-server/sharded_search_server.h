@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <execution>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+// Partitions documents by id hash between several SearchServer shards, which are
+// indexed and searched concurrently. IDF is computed over all shards, so results
+// are the same as those of a single server with all the documents.
+class ShardedSearchServer {
+public:
+    template<typename StopWords>
+    ShardedSearchServer(const StopWords& stop_words, size_t shard_count) {
+        if (shard_count == 0) {
+            throw(invalid_argument("Shard count must be positive"s));
+        }
+        shards_.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards_.emplace_back(stop_words);
+        }
+    }
+
+    void AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+        GetShard(document_id).AddDocument(document_id, document, status, ratings);
+    }
+
+    // Shards add their documents in parallel. When a document is rejected, documents
+    // of its shard after it aren't added and the error of the earliest rejected
+    // document of the batch is rethrown once all shards are done. Other errors,
+    // such as bad_alloc, aren't tied to a document and are rethrown first.
+    void AddDocuments(const vector<NewDocument>& documents) {
+        vector<vector<NewDocument>> shard_documents(shards_.size());
+        vector<vector<size_t>> shard_positions(shards_.size());
+        for (size_t i = 0; i < documents.size(); ++i) {
+            const size_t shard = GetShardIndex(documents[i].id);
+            shard_documents[shard].push_back(documents[i]);
+            shard_positions[shard].push_back(i);
+        }
+        vector<pair<size_t, exception_ptr>> shard_errors(shards_.size(), {documents.size(), nullptr});
+        vector<exception_ptr> shard_failures(shards_.size());
+        vector<size_t> shard_indexes(shards_.size());
+        iota(shard_indexes.begin(), shard_indexes.end(), 0);
+        for_each(execution::par, shard_indexes.begin(), shard_indexes.end(), [&](size_t shard) {
+            const int document_count = shards_[shard].GetDocumentCount();
+            try {
+                shards_[shard].AddDocuments(shard_documents[shard]);
+            } catch (const invalid_argument&) {
+                // Documents before the rejected one are added.
+                const size_t rejected = shards_[shard].GetDocumentCount() - document_count;
+                shard_errors[shard] = {shard_positions[shard][rejected], current_exception()};
+            } catch (...) {
+                shard_failures[shard] = current_exception();
+            }
+        });
+        for (const exception_ptr& failure : shard_failures) {
+            if (failure) {
+                rethrow_exception(failure);
+            }
+        }
+        const auto first_error = min_element(shard_errors.begin(), shard_errors.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        if (first_error->second) {
+            rethrow_exception(first_error->second);
+        }
+    }
+
+    void RemoveDocument(int document_id) {
+        GetShard(document_id).RemoveDocument(document_id);
+    }
+
+    // The filter may be called from several threads at once.
+    template<typename Filter>
+    vector<Document> FindTopDocuments(string_view raw_query, Filter filter,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT, size_t offset = 0) const {
+        QueryScratch scratch;
+        SearchServer::Query query = shards_.front().ParseQuery(raw_query, scratch.GetResource());
+        const int document_count = GetDocumentCount();
+        if (document_count == 0) {
+            return {};
+        }
+        // Same arithmetic as in SearchServer, so relevance is bit for bit the same.
+        const double log_document_count = log(static_cast<double>(document_count));
+        query.inverse_document_freqs.reserve(query.plus_words.size());
+        for (const string_view word : query.plus_words) {
+            size_t document_freq = 0;
+            for (const SearchServer& shard : shards_) {
+                if (const PostingList* postings = shard.FindPostings(word)) {
+                    document_freq += postings->size();
+                }
+            }
+            query.inverse_document_freqs.push_back(
+                document_freq == 0 ? 0 : log_document_count - log(static_cast<double>(document_freq)));
+        }
+
+        // Every shard returns its own top of the offset and the requested documents.
+        const size_t shard_result_count = offset + min(max_result_count, numeric_limits<size_t>::max() - offset);
+        vector<vector<Document>> shard_documents(shards_.size());
+        vector<size_t> shard_indexes(shards_.size());
+        iota(shard_indexes.begin(), shard_indexes.end(), 0);
+        for_each(execution::par, shard_indexes.begin(), shard_indexes.end(), [&](size_t shard) {
+            shard_documents[shard] = shards_[shard].FindTopDocuments(execution::seq, query, filter, shard_result_count, 0);
+        });
+
+        vector<Document> matched_documents;
+        for (const vector<Document>& documents : shard_documents) {
+            matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+        }
+        if (offset >= matched_documents.size()) {
+            return {};
+        }
+        const auto first = matched_documents.begin() + offset;
+        const auto last = first + min(max_result_count, matched_documents.size() - offset);
+        partial_sort(matched_documents.begin(), last, matched_documents.end(), CompareDocumentsByRelevance);
+        return {first, last};
+    }
+
+    vector<Document> FindTopDocuments(string_view raw_query, DocumentStatus status,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT, size_t offset = 0) const {
+        DocumentFilter status_filter;
+        status_filter.status = status;
+        return FindTopDocuments(raw_query, status_filter, max_result_count, offset);
+    }
+
+    vector<Document> FindTopDocuments(string_view raw_query) const {
+        return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+    }
+
+    tuple<vector<string_view>, DocumentStatus> MatchDocument(string_view raw_query, int document_id) const {
+        return GetShard(document_id).MatchDocument(raw_query, document_id);
+    }
+
+    int GetDocumentCount() const {
+        int document_count = 0;
+        for (const SearchServer& shard : shards_) {
+            document_count += shard.GetDocumentCount();
+        }
+        return document_count;
+    }
+
+    size_t GetShardCount() const {
+        return shards_.size();
+    }
+
+    const SearchServer& GetShardByIndex(size_t index) const {
+        return shards_.at(index);
+    }
+
+private:
+    vector<SearchServer> shards_;
+
+    size_t GetShardIndex(int document_id) const {
+        return hash<int>{}(document_id) % shards_.size();
+    }
+
+    SearchServer& GetShard(int document_id) {
+        return shards_[GetShardIndex(document_id)];
+    }
+
+    const SearchServer& GetShard(int document_id) const {
+        return shards_[GetShardIndex(document_id)];
+    }
+};
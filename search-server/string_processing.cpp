@@ -0,0 +1,21 @@
+#include "string_processing.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+void CheckIfWordIsValid(string_view word) {
+    // A valid word must not contain special characters
+    if (any_of(begin(word), end(word), [](char c) {
+        return c >= '\0' && c < ' ';
+    })) {
+        throw(invalid_argument("Word cannot contain special symbols"s));
+    }
+}
+
+vector<string_view> SplitIntoWords(string_view text) {
+    vector<string_view> words;
+    SplitIntoWords(text, words);
+    return words;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+void CheckIfWordIsValid(string_view word);
+
+// Returned words point into text, which must outlive them.
+template<typename Words>
+void SplitIntoWords(string_view text, Words& words) {
+    words.reserve(count(text.begin(), text.end(), ' ') + 1);
+    while (true) {
+        const size_t word_begin = text.find_first_not_of(' ');
+        if (word_begin == string_view::npos) {
+            break;
+        }
+        text.remove_prefix(word_begin);
+        const string_view word = text.substr(0, text.find(' '));
+        CheckIfWordIsValid(word);
+        words.push_back(word);
+        text.remove_prefix(word.size());
+    }
+}
+
+vector<string_view> SplitIntoWords(string_view text);
@@ -0,0 +1,1882 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "concurrent_search_server.h"
+#include "ingest_documents.h"
+#include "paginator.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "sharded_search_server.h"
+#include "test_framework.h"
+
+using namespace std;
+
+// -------- Начало модульных тестов поисковой системы ----------
+
+// Тест проверяет, что поисковая система исключает стоп-слова при добавлении документов
+void TestExcludeStopWordsFromAddedDocumentContent() {
+    const int doc_id = 42;
+    const string content = "cat in the city"s;
+    const vector<int> ratings = {1, 2, 3};
+    {
+        SearchServer server;
+        (void) server.AddDocument(doc_id, content, DocumentStatus::ACTUAL, ratings);
+        const auto found_docs = server.FindTopDocuments("in"s);
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        const Document& doc0 = found_docs[0];
+        ASSERT_EQUAL(doc0.id, doc_id);
+    }
+
+    {
+        SearchServer server{"in the"s};
+        (void) server.AddDocument(doc_id, content, DocumentStatus::ACTUAL, ratings);
+        const auto found_docs = server.FindTopDocuments("in"s);
+        ASSERT_HINT(found_docs.empty(), "Stop words must be excluded from documents"s);
+    }
+}
+
+
+void TestDocumentsWithMinusWordsAreExcludedFromResults() {
+    const int doc_id = 42;
+    const string content = "cat in the city"s;
+    const vector<int> ratings = {1, 2, 3};
+
+    SearchServer server;
+    (void) server.AddDocument(doc_id, content, DocumentStatus::ACTUAL, ratings);
+    // Ищем кошку, но не в городе, поэтому -city должен исключить документы с словом "city" из выборки
+    const auto found_docs = server.FindTopDocuments("cat -city"s);
+    ASSERT_HINT(found_docs.empty(), "Minus words should exlude document from search result"s);
+}
+
+void TestMatchDocumentMethod() {
+    const int doc_id = 42;
+    const string content = "cat in the city"s;
+    const vector<int> ratings = {1, 2, 3};
+
+    // Запрос без минус слов, MatchDocument должен вернуть пересечение из слов между запросом и документом.
+    {
+        SearchServer server;
+        (void) server.AddDocument(doc_id, content, DocumentStatus::ACTUAL, ratings);
+        vector<string_view> expected_words = {"cat"sv, "city"sv};
+        const auto match_result = server.MatchDocument("cat city"s, doc_id);
+        ASSERT_EQUAL(get<0>(match_result), expected_words);
+        ASSERT_EQUAL(get<1>(match_result), DocumentStatus::ACTUAL);
+    }
+
+    // Минус-слова в запросе, MatchDocument должен вернуть пустой список слов.
+
+    {
+        SearchServer server;
+        (void) server.AddDocument(doc_id, content, DocumentStatus::ACTUAL, ratings);
+        const auto match_result = server.MatchDocument("cat -city"s, doc_id);
+        ASSERT(get<0>(match_result).empty());
+        ASSERT_EQUAL(get<1>(match_result), DocumentStatus::ACTUAL);
+    }
+    // Невалидные поисковые слова для метода MatchDocument.
+    {
+        SearchServer server;
+        (void) server.AddDocument(doc_id, content, DocumentStatus::ACTUAL, ratings);
+        vector<string> test_cases = {
+            "cat --city"s,
+            "cat -"s,
+            "cat \x12"s,
+        };
+        for (const auto& case_words : test_cases) {
+            ASSERT_THROWS(server.MatchDocument(case_words, doc_id), invalid_argument);
+        }
+    }
+    // Вызов MatchDocument с отрицательным id документа.
+    {
+        SearchServer server;
+        ASSERT_THROWS(server.MatchDocument("cat -city"s, -1), invalid_argument);
+    }
+}
+
+void TestMatchDocumentWithExecutionPolicy() {
+    SearchServer server{"in the"s};
+    (void) server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    (void) server.AddDocument(2, "dog and cat in the park"s, DocumentStatus::BANNED, {2});
+    (void) server.AddDocument(3, "rat"s, DocumentStatus::ACTUAL, {3});
+
+    // Параллельная версия возвращает те же слова, что и последовательная, без повторов.
+    for (const string& query : {"cat city"s, "park dog cat park dog"s, "cat -park"s, "-rat rat"s, "unknown"s, "the"s}) {
+        for (const int id : {1, 2, 3}) {
+            const auto expected = server.MatchDocument(query, id);
+            ASSERT(server.MatchDocument(execution::seq, query, id) == expected);
+            ASSERT(server.MatchDocument(execution::par, query, id) == expected);
+        }
+    }
+    {
+        const auto [words, status] = server.MatchDocument(execution::par, "park dog cat park dog"s, 2);
+        ASSERT_EQUAL(words, vector<string_view>({"cat"sv, "dog"sv, "park"sv}));
+        ASSERT_EQUAL(status, DocumentStatus::BANNED);
+    }
+    // Найденные слова указывают в индекс, а не в текст запроса.
+    {
+        string query = "city cat"s;
+        const auto [words, status] = server.MatchDocument(execution::par, query, 1);
+        query.assign(query.size(), 'x');
+        ASSERT_EQUAL(words, vector<string_view>({"cat"sv, "city"sv}));
+    }
+    // Ошибки те же, что и у последовательной версии.
+    ASSERT_THROWS(server.MatchDocument(execution::par, "cat --city"s, 1), invalid_argument);
+    ASSERT_THROWS(server.MatchDocument(execution::par, "cat"s, -1), invalid_argument);
+    ASSERT_THROWS(server.MatchDocument(execution::par, "cat"s, 4), out_of_range);
+}
+
+void TestDocumentsAreSortedByItDescendingRelevance() {
+    /*
+    Релевантность документа зависит от TF-IDF индекса.
+    */
+    struct DocumentData {
+        int id;
+        string content;
+        vector<int> ratings;
+    };
+    vector<DocumentData> test_documents_data = {
+        {42, "cat in the city"s, {1, 2, 3}},
+        {43, "dog in the city of Moscow"s, {1, 2, 3}},
+        {44, "cat and dog in the city with mayor cat"s, {1, 2, 3}},
+        {45, "cat in the city of Beijing of China country"s, {1, 2, 3}},
+    };
+
+    SearchServer server{"in the"s};
+    for (const auto& [id, content, ratings] : test_documents_data) {
+        (void) server.AddDocument(id, content, DocumentStatus::ACTUAL, ratings);
+    }
+    // Для такого запроса более релевантным документом должен быть документ под id 43,
+    // т.к. IDF для документов 43 и 44 будет одинаков, но TF поднимет документ с id 43 вверх, т.к.
+    // в этом документе меньше слов.
+    {
+
+        const auto found_docs = server.FindTopDocuments("dog has big puffy tail"s);
+        ASSERT_EQUAL(found_docs.size(), 2u);
+        ASSERT_EQUAL(found_docs[0].id, 43);
+        ASSERT_EQUAL(found_docs[1].id, 44);
+        double prev_relevance = found_docs[0].relevance;
+        for (auto& doc : found_docs) {
+            // Если из текущего relevance вычесть relevance предыдущего документа в очереди, то должно получиться число
+            // меньше, либо равное нулю, т.к. первыми в выдаче должны идти документы с бОльшим relevance.
+            ASSERT_HINT(doc.relevance - prev_relevance <= 0, "Documents are not sorted by it's relevance"s);
+            prev_relevance = doc.relevance;
+        }
+    }
+    // Чем больше слов в документе тем меньше TF слова из поискового запроса, а соответственно и произведение TF-IDF, поэтому
+    // для такого запроса вверху должен оказаться документ под id 42, а 44 уйти вниз.
+    // 45ый должен уйти вниз, т.к. для слова cat TF в документе 44 выше, а соответственно и TF-IDF поднимет его в поиске выше.
+    {
+        const auto found_docs = server.FindTopDocuments("big fluffy cat"s);
+        ASSERT_EQUAL(found_docs.size(), 3u);
+        ASSERT_EQUAL(found_docs[0].id, 42);
+        ASSERT_EQUAL(found_docs[1].id, 44);
+        ASSERT_EQUAL(found_docs[2].id, 45);
+        double prev_relevance = found_docs[0].relevance;
+        for (auto& doc : found_docs) {
+            // Если из текущего relevance вычесть relevance предыдущего документа в очереди, то должно получиться число
+            // меньше, либо равное нулю, т.к. первыми в выдаче должны идти документы с бОльшим relevance.
+            ASSERT_HINT(doc.relevance - prev_relevance <= 0, "Documents are not sorted by it's relevance"s);
+            prev_relevance = doc.relevance;
+        }
+    }
+}
+
+void TestDocumentsRatingCalculations() {
+    const int doc_id = 42;
+    const string content = "cat in the city"s;
+
+    // Рейтинг документа для документа без оценок должен быть нулём.
+    {
+        SearchServer server;
+        const vector<int> ratings = {};
+        (void) server.AddDocument(doc_id, content, DocumentStatus::ACTUAL, ratings);
+        const auto found_docs = server.FindTopDocuments("cat city"s);
+        const Document& doc = found_docs[0];
+        ASSERT_EQUAL(doc.rating, 0.0);
+    }
+    // Если переданы оценки - рейтинг документа это среднее арифметическое всех оценок.
+    // Для оценок 5 4 5 3 среднее арифметическое = 4.25, но т.к. рейтинг у нас целочисленое значение, то получаем 4.
+    {
+        SearchServer server;
+        const vector<int> ratings = {5, 4, 5, 3};
+        (void) server.AddDocument(doc_id, content, DocumentStatus::ACTUAL, ratings);
+        const auto found_docs = server.FindTopDocuments("cat city"s);
+        const Document& doc = found_docs[0];
+        ASSERT_EQUAL(doc.rating, 4);
+    }
+}
+
+void TestDocumentsFiltering() {
+    struct DocumentData {
+        int id;
+        string content;
+        vector<int> ratings;
+        DocumentStatus status;
+    };
+    vector<DocumentData> test_documents_data = {
+        {1, "cat in the city"s, {2, 3, 3}, DocumentStatus::ACTUAL},
+        {2, "dog in the city of Moscow"s, {4, 5, 3}, DocumentStatus::ACTUAL},
+        {3, "cat and dog in the city with mayor rat"s, {5, 5, 5}, DocumentStatus::ACTUAL},
+        {4, "cat in the city of Beijing of China country"s, {3, 3, 4}, DocumentStatus::BANNED},
+    };
+
+    SearchServer server{"in the"s};
+    for (const auto& [id, content, ratings, status] : test_documents_data) {
+        (void) server.AddDocument(id, content, status, ratings);
+    }
+
+    // Проверяем возможность фильтровать по ID, получаем только чётные документы.
+    {
+        const auto found_docs = server.FindTopDocuments(
+            "city"s, [](int document_id, DocumentStatus status, int rating) {
+                if (document_id % 2 != 0) {
+                    return false;
+                }
+                return true;
+            }
+        );
+        ASSERT_EQUAL(found_docs.size(), 2u);
+        ASSERT_EQUAL(found_docs[0].id, 2);
+        ASSERT_EQUAL(found_docs[1].id, 4);
+    }
+    // Попробуем отфильтровать по статусу
+    {
+        const auto found_docs = server.FindTopDocuments(
+            "city"s, [](int document_id, DocumentStatus status, int rating) {
+                return status == DocumentStatus::BANNED;
+            }
+        );
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT_EQUAL(found_docs[0].id, 4);
+    }
+    // Получим все документы с рейтингом больше 4.
+    {
+        const auto found_docs = server.FindTopDocuments(
+            "city"s, [](int document_id, DocumentStatus status, int rating) {
+                return rating > 4;
+            }
+        );
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT_EQUAL(found_docs[0].id, 3);
+    }
+}
+
+void TestFindTopDocumentsWithSpecificStatus() {
+    struct DocumentData {
+        int id;
+        string content;
+        vector<int> ratings;
+        DocumentStatus status;
+    };
+    vector<DocumentData> test_documents_data = {
+        {1, "cat in the city"s, {2, 3, 3}, DocumentStatus::ACTUAL},
+        {2, "dog in the city of Moscow"s, {4, 5, 3}, DocumentStatus::ACTUAL},
+        {3, "cat and dog in the city with mayor rat"s, {5, 5, 5}, DocumentStatus::IRRELEVANT},
+        {4, "cat in the city of Beijing of China country"s, {3, 3, 4}, DocumentStatus::IRRELEVANT},
+    };
+
+    SearchServer server{"in the"s};
+    for (const auto& [id, content, ratings, status] : test_documents_data) {
+        (void) server.AddDocument(id, content, status, ratings);
+    }
+    // Без явного указания статуса, метод возвращает все документы с статусом ACTUAL.
+    {
+        const auto found_docs = server.FindTopDocuments("cat and city"s);
+        ASSERT_EQUAL(found_docs.size(), 2u);
+    }
+    // Если указан статус, то должны найтись документы только с этим статусом
+    {
+        const auto found_docs = server.FindTopDocuments("cat"s, DocumentStatus::IRRELEVANT);
+        ASSERT_EQUAL(found_docs.size(), 2u);
+        for (const auto& doc : found_docs) {
+            if (doc.id == 1 || doc.id == 2) {
+                ASSERT_HINT(false, "Documents with incorrect status were found"s); // Документы с другим статусом
+            }
+        }
+    }
+    // Если документов с таким статусом нет, то должен вернуться пустой результат.
+    {
+        const auto found_docs = server.FindTopDocuments("cat"s, DocumentStatus::BANNED);
+        ASSERT_HINT(found_docs.empty(), "Search Server returned documents with incorrect status"s);
+    }
+}
+
+void TestDocsRelevanceAreCalculatedCorrectly() {
+    struct DocumentData {
+        int id;
+        string content;
+        vector<int> ratings;
+    };
+    vector<DocumentData> test_documents_data = {
+        {42, "cat in the city"s, {1, 2, 3}},
+        {43, "dog in the city of Moscow"s, {1, 2, 3}},
+        {44, "cat and dog in the city with mayor cat"s, {1, 2, 3}},
+        {45, "cat in the city of Beijing of China country"s, {1, 2, 3}},
+    };
+
+    SearchServer server{"in the and of"s};
+    for (const auto& [id, content, ratings] : test_documents_data) {
+        (void) server.AddDocument(id, content, DocumentStatus::ACTUAL, ratings);
+    }
+    /* Мы можем рассчитать IDF слов сразу:
+     * 1. cat     = log(4 / 3) = 0.2851
+     * 2. city    = log(4 / 4) = 0.00
+     * 3. dog     = log(4 / 2) = 0.6931
+     * 4. Moscow  = log(4 / 1) = 1.3862
+     * 5. with    = log(4 / 1) = 1.3862
+     * 6. mayor   = log(4 / 1) = 1.3862
+     * 7. Beijing = log(4 / 1) = 1.3862
+     * 8. China   = log(4 / 1) = 1.3862
+     * 9. country = log(4 / 1) = 1.3862
+     *
+     * + Посчитаем итоговый TF для слов документов:
+     *
+     *          0.5        0.5
+     *   42 -> "cat in the city"
+     *          0.33       0.33    0.33
+     *   43 -> "dog in the city of Moscow"
+     *          0.33    0.16       0.16 0.16 0.16  -//-
+     *   44 -> "cat and dog in the city with mayor cat"
+     *          0.2        0.2     0.2        0.2   0.2
+     *   45 -> "cat in the city of Beijing of China country"
+     *
+     * для запроса "cat in the city" мы найдём все 4 документа c расчётными relevance:
+     * 42 -> (0.5 * 0.2851) + (0.5 * 0.0) = 0.14255
+     * 43 -> (0.33 * 0.0) = 0
+     * 44 -> (0.33 * 0.2851) + (0.33 * 0.0) = 0.09408
+     * 45 -> (0.2 * 0.2851) + (0.2 * 0.0) = 0.05702
+     *
+     * Получается документы получим в следующем порядке: 42, 44, 45, 43.
+     */
+
+    // Погрешность в две десятки? Ну, может быть, ручные вычисления вряд ли точно попадут в ожидания от программы, поэтому так.
+    const double EPSILON_TEST = 0.002;
+    {
+        const auto found_docs = server.FindTopDocuments("cat in the city"s);
+        vector<tuple<int, double>> expected_result = {
+            {42, 0.14255},
+            {44, 0.09408},
+            {45, 0.05702},
+            {43, 0.00000}
+        };
+        for (int i = 0; i < static_cast<int>(expected_result.size()); ++i) {
+            const auto [expected_id, expected_relevance] = expected_result[i];
+            ASSERT_EQUAL(found_docs[i].id, expected_id);
+            ASSERT_HINT(abs(found_docs[i].relevance - expected_relevance) < EPSILON_TEST, "Error threshold exceeded maximum allowed value."s);
+        }
+
+    }
+
+}
+
+void TestSearchServerInitializer() {
+    const set<string, less<>> expected = {"и"s, "в"s, "на"s};
+    {
+        const vector<string> stop_words_vector = {"и"s, "в"s, "на"s, ""s, "в"s};
+        SearchServer search_server(stop_words_vector);
+        const auto& actual = search_server.GetStopWords();
+        ASSERT_EQUAL(expected, actual);
+    }
+    {
+        const set<string> stop_words_set = {"и"s, "в"s, "на"s};
+        SearchServer search_server(stop_words_set);
+        const auto& actual = search_server.GetStopWords();
+        ASSERT_EQUAL(expected, actual);
+    }
+    {
+        SearchServer search_server("  и  в на   "s);
+        const auto& actual = search_server.GetStopWords();
+        ASSERT_EQUAL(expected, actual);
+    }
+    // Тесты на спец символы в стоп слове
+    {
+        for (auto word : {"\x00"s, "\x0F"s, "\x1F"s}) {
+            vector<string> stop_words = {"и"s, "b"s, word};
+            ASSERT_THROWS(SearchServer search_server(stop_words), invalid_argument);
+        }
+    }
+}
+
+void TestAddDocument() {
+    // Проверяем, что не можем добавить документ с отрицательным id.
+    string content = "Test adding documents"s;
+    vector<int> ratings = {5, 5, 5};
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    {
+        SearchServer search_server;
+        int id = -1;
+        ASSERT_THROWS(search_server.AddDocument(id, content, status, ratings), invalid_argument);
+    }
+    // Проверяем, что не можем добавить документ с id, если документ с таким id уже
+    // добавлен
+    {
+        SearchServer search_server;
+        int id = 1;
+        search_server.AddDocument(id, content, status, ratings);
+        string content2 = "Test adding another document"s;
+        ASSERT_THROWS(search_server.AddDocument(id, content2, status, ratings), invalid_argument);
+    }
+    // Не можем добавить документ, если в тексте есть слова с спецсимволами.
+    {
+        SearchServer search_server;
+        int id = 1;
+        string content = "Test adding another document\x10\x12\x15"s;
+        ASSERT_THROWS(search_server.AddDocument(id, content, status, ratings), invalid_argument);
+        ASSERT_THROWS(search_server.AddDocument(id, "Test \x12 adding"s, status, ratings), invalid_argument);
+    }
+}
+
+void TestSearchServerCopy() {
+    optional<SearchServer> original(in_place, "in the"s);
+    {
+        // Текст документа уничтожается сразу после добавления, индекс хранит свои копии слов.
+        string content = "cat in the city"s;
+        original->AddDocument(1, content, DocumentStatus::ACTUAL, {1});
+    }
+    original->AddDocument(2, "dog in the city"s, DocumentStatus::ACTUAL, {2});
+
+    // Копия должна продолжать работать после уничтожения оригинала.
+    SearchServer copy = *original;
+    SearchServer assigned;
+    assigned = *original;
+    original.reset();
+    for (const SearchServer* server : {&copy, &assigned}) {
+        const auto found_docs = server->FindTopDocuments("cat city"s);
+        ASSERT_EQUAL(found_docs.size(), 2u);
+        ASSERT_EQUAL(found_docs[0].id, 1);
+        const auto [words, status] = server->MatchDocument("dog city"s, 2);
+        const vector<string_view> expected_words = {"city"sv, "dog"sv};
+        ASSERT_EQUAL(words, expected_words);
+    }
+    copy.AddDocument(3, "cat and dog"s, DocumentStatus::ACTUAL, {3});
+    ASSERT_EQUAL(copy.FindTopDocuments("cat"s).size(), 2u);
+    ASSERT_EQUAL(assigned.FindTopDocuments("cat"s).size(), 1u);
+}
+
+void TestFindTopDocsWithInvalidQuery() {
+    SearchServer server;
+    vector<string> test_cases = {
+        "cat --city"s,
+        "cat -"s,
+        "cat \x12"s,
+    };
+    for (const auto& case_words : test_cases) {
+        ASSERT_THROWS(server.FindTopDocuments(case_words), invalid_argument);
+    }
+}
+
+void TestGetDocumentId() {
+    struct DocumentData {
+        int id;
+        string content;
+        vector<int> ratings;
+    };
+    vector<DocumentData> test_documents_data = {
+        {4, "cat in the city"s, {1, 2, 3}},
+        {55, "cat in the city of Beijing of China country"s, {1, 2, 3}},
+        {49, "cat and dog in the city with mayor cat"s, {1, 2, 3}},
+        {43, "dog in the city of Moscow"s, {1, 2, 3}},
+    };
+
+    SearchServer server;
+    for (const auto& [id, content, ratings] : test_documents_data) {
+        (void) server.AddDocument(id, content, DocumentStatus::ACTUAL, ratings);
+    }
+    ASSERT(server.GetDocumentId(0) == 4);
+    ASSERT(server.GetDocumentId(1) == 55);
+    ASSERT(server.GetDocumentId(2) == 49);
+    ASSERT(server.GetDocumentId(3) == 43);
+
+    // GetDocumentById за пределами кол-ва документов.
+    // Отрицательные айди документа
+    for (int doc_id : {4, -1}) {
+        ASSERT_THROWS(server.GetDocumentId(doc_id), out_of_range);
+    }
+}
+
+void TestDocumentsAddedInArbitraryIdOrder() {
+    SearchServer server;
+    (void) server.AddDocument(5, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    (void) server.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {2});
+    (void) server.AddDocument(3, "dog in the park"s, DocumentStatus::ACTUAL, {3});
+    (void) server.AddDocument(2, "cat cat cat"s, DocumentStatus::ACTUAL, {4});
+
+    // Документы, добавленные не по порядку id, находятся и матчатся так же, как добавленные по порядку.
+    const auto found_docs = server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(found_docs.size(), 3u);
+    ASSERT_EQUAL(found_docs[0].id, 2);
+    ASSERT_EQUAL(found_docs[1].id, 1);
+    ASSERT_EQUAL(found_docs[2].id, 5);
+    for (int id : {1, 2, 3, 5}) {
+        const auto [words, status] = server.MatchDocument("cat dog"s, id);
+        ASSERT_HINT(!words.empty(), "Every document contains cat or dog"s);
+    }
+    const auto [words, status] = server.MatchDocument("cat dog -park"s, 3);
+    ASSERT(words.empty());
+}
+
+void TestRemoveDocument() {
+    struct DocumentData {
+        int id;
+        string content;
+        vector<int> ratings;
+    };
+    const vector<DocumentData> test_documents_data = {
+        {42, "cat in the city"s, {1, 2, 3}},
+        {43, "dog in the city of Moscow"s, {1, 2, 3}},
+        {44, "cat and dog in the city with mayor cat"s, {1, 2, 3}},
+        {45, "cat in the city of Beijing of China country"s, {1, 2, 3}},
+    };
+    SearchServer server{"in the and of"s};
+    for (const auto& [id, content, ratings] : test_documents_data) {
+        (void) server.AddDocument(id, content, DocumentStatus::ACTUAL, ratings);
+    }
+
+    // Частоты слов документа доступны по его id.
+    const map<string_view, double> expected_freqs = {{"cat"sv, 0.5}, {"city"sv, 0.5}};
+    ASSERT_EQUAL(server.GetWordFrequencies(42), expected_freqs);
+    ASSERT(server.GetWordFrequencies(100).empty());
+
+    server.RemoveDocument(44);
+    server.RemoveDocument(execution::par, 42);
+    // Удаление отсутствующего документа ничего не делает.
+    server.RemoveDocument(100);
+    server.RemoveDocument(execution::par, 42);
+
+    ASSERT_EQUAL(server.GetDocumentCount(), 2);
+    ASSERT_EQUAL(server.GetDocumentId(0), 43);
+    ASSERT_EQUAL(server.GetDocumentId(1), 45);
+    ASSERT(server.GetWordFrequencies(42).empty());
+    ASSERT(server.FindTopDocuments("mayor"s).empty());
+
+    // Удалённые документы не находятся, а IDF считается по оставшимся: log(2 / 1) для cat.
+    const auto found_docs = server.FindTopDocuments("cat dog"s);
+    ASSERT_EQUAL(found_docs.size(), 2u);
+    ASSERT_EQUAL(found_docs[0].id, 43);
+    ASSERT_EQUAL(found_docs[1].id, 45);
+    ASSERT(abs(found_docs[1].relevance - 0.2 * log(2.0)) < EPSILON);
+
+    // Слова удалённых документов можно снова проиндексировать.
+    (void) server.AddDocument(44, "mayor cat"s, DocumentStatus::ACTUAL, {5});
+    ASSERT_EQUAL(server.FindTopDocuments("mayor"s).size(), 1u);
+    const SearchServer copy = server;
+    ASSERT_EQUAL(copy.GetWordFrequencies(44).size(), 2u);
+    ASSERT_EQUAL(copy.FindTopDocuments("mayor"s).size(), 1u);
+}
+
+void TestRemoveDuplicates() {
+    SearchServer server{"and with"s};
+    (void) server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    (void) server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // Дубликат документа 2, будет удалён.
+    (void) server.AddDocument(3, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // Отличие только в стоп-словах, считается дубликатом.
+    (void) server.AddDocument(4, "funny pet and curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // Множество слов такое же, как в id 1, считается дубликатом.
+    (void) server.AddDocument(5, "funny funny pet and nasty nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    // Новые слова относительно id 1, но множество слов совпадает с id 0.
+    (void) server.AddDocument(6, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    // Добавлен позже, но id меньше, поэтому удаляется документ 6.
+    (void) server.AddDocument(0, "very nasty rat and not very funny pet"s, DocumentStatus::ACTUAL, {1, 2});
+    (void) server.AddDocument(8, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, {1, 2});
+    (void) server.AddDocument(9, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+
+    const vector<int> expected_duplicate_ids = {3, 4, 5, 6};
+    ASSERT_EQUAL(RemoveDuplicates(server), expected_duplicate_ids);
+    const vector<int> remaining_ids(server.begin(), server.end());
+    const vector<int> expected_ids = {1, 2, 0, 8, 9};
+    ASSERT_EQUAL(remaining_ids, expected_ids);
+}
+
+void TestSnapshot() {
+    const string path = (filesystem::temp_directory_path() / "search_server_test.snapshot"s).string();
+    SearchServer server{"in the and of"s};
+    (void) server.AddDocument(42, "cat in the city"s, DocumentStatus::ACTUAL, {1, 2, 3});
+    (void) server.AddDocument(43, "dog in the city of Moscow"s, DocumentStatus::BANNED, {4, 5});
+    (void) server.AddDocument(41, "cat and dog in the city with mayor cat"s, DocumentStatus::ACTUAL, {-1});
+    (void) server.AddDocument(45, "cat in the city of Beijing of China country"s, DocumentStatus::IRRELEVANT, {});
+    (void) server.AddDocument(46, "city of Paris"s, DocumentStatus::ACTUAL, {2});
+    (void) server.AddDocument(47, "in the"s, DocumentStatus::ACTUAL, {1});
+    server.RemoveDocument(46);
+    server.SaveSnapshot(path);
+
+    optional<SearchServer> loaded = SearchServer::LoadSnapshot(path);
+    filesystem::remove(path);
+    ASSERT_EQUAL(loaded->GetStopWords(), server.GetStopWords());
+    ASSERT_EQUAL(loaded->GetDocumentCount(), server.GetDocumentCount());
+    ASSERT_EQUAL(vector<int>(loaded->begin(), loaded->end()), vector<int>(server.begin(), server.end()));
+
+    // Загруженный снимок отвечает на запросы так же, как исходный сервер.
+    const auto check_same_results = [&server](const SearchServer& checked) {
+        for (const string& query : {"cat city"s, "dog -mayor"s, "Paris"s, "China country cat"s}) {
+            for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED, DocumentStatus::IRRELEVANT}) {
+                const auto expected = server.FindTopDocuments(query, status);
+                const auto found_docs = checked.FindTopDocuments(query, status);
+                ASSERT_EQUAL(found_docs.size(), expected.size());
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    ASSERT_EQUAL(found_docs[i].id, expected[i].id);
+                    ASSERT_EQUAL(found_docs[i].rating, expected[i].rating);
+                    ASSERT_EQUAL(found_docs[i].relevance, expected[i].relevance);
+                }
+            }
+        }
+        for (const int document_id : server) {
+            ASSERT(checked.MatchDocument("cat dog mayor"s, document_id) == server.MatchDocument("cat dog mayor"s, document_id));
+            ASSERT_EQUAL(checked.GetWordFrequencies(document_id), server.GetWordFrequencies(document_id));
+        }
+    };
+    check_same_results(*loaded);
+
+    // Копия снимка работает после уничтожения оригинала.
+    SearchServer copy = *loaded;
+    loaded.reset();
+    check_same_results(copy);
+
+    // Загруженный снимок можно изменять.
+    for (SearchServer* changed : {&server, &copy}) {
+        changed->RemoveDocument(41);
+        changed->AddDocument(48, "cat with fluffy tail"s, DocumentStatus::ACTUAL, {5});
+        changed->AddDocument(40, "fluffy dog"s, DocumentStatus::ACTUAL, {3});
+    }
+    check_same_results(copy);
+    ASSERT_EQUAL(copy.FindTopDocuments("fluffy"s).size(), 2u);
+
+    ASSERT_THROWS(SearchServer::LoadSnapshot(path), runtime_error);
+    {
+        ofstream(path) << "not a snapshot"s;
+        ASSERT_THROWS(SearchServer::LoadSnapshot(path), runtime_error);
+        filesystem::remove(path);
+    }
+    // Счётчики заголовка, при умножении на размер элемента переполняющиеся
+    // до размера, умещающегося в файле, отвергаются при загрузке.
+    for (const auto& [offset, added_count] : {pair(16, uint64_t{1} << 61), pair(32, uint64_t{1} << 62)}) {
+        copy.SaveSnapshot(path);
+        {
+            fstream file(path, ios::binary | ios::in | ios::out);
+            uint64_t count = 0;
+            file.seekg(offset);
+            file.read(reinterpret_cast<char*>(&count), sizeof(count));
+            count += added_count;
+            file.seekp(offset);
+            file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        }
+        ASSERT_THROWS(SearchServer::LoadSnapshot(path), runtime_error);
+        filesystem::remove(path);
+    }
+    // Постинги проверяются при первом обращении: id за пределами документов
+    // приводит к исключению в запросе, а не к выходу за границы массивов.
+    {
+        SearchServer single_server;
+        (void) single_server.AddDocument(5, "cat"s, DocumentStatus::ACTUAL, {1});
+        single_server.SaveSnapshot(path);
+        {
+            // Заголовок, один документ и одно слово занимают 112 байт, за ними идут id постингов.
+            fstream file(path, ios::binary | ios::in | ios::out);
+            const int32_t damaged_id = 7;
+            file.seekp(112);
+            file.write(reinterpret_cast<const char*>(&damaged_id), sizeof(damaged_id));
+        }
+        const SearchServer damaged = SearchServer::LoadSnapshot(path);
+        filesystem::remove(path);
+        ASSERT_EQUAL(damaged.GetDocumentCount(), 1);
+        ASSERT_THROWS(damaged.FindTopDocuments("cat"s), runtime_error);
+        ASSERT_THROWS(damaged.FindTopDocuments(execution::par, "cat"s), runtime_error);
+        ASSERT_THROWS(damaged.MatchDocument(execution::par, "cat"s, 5), runtime_error);
+    }
+    // Запрос, прерванный повреждённым вторым словом, не оставляет релевантности
+    // в буферах потока для следующих запросов.
+    {
+        SearchServer healthy;
+        (void) healthy.AddDocument(1, "alpha gamma"s, DocumentStatus::ACTUAL, {1});
+        (void) healthy.AddDocument(2, "delta"s, DocumentStatus::ACTUAL, {1});
+        healthy.SaveSnapshot(path);
+        {
+            // Заголовок, два документа и три слова занимают 216 байт, за ними идут id постингов.
+            // Слова записаны в порядке пула текста, который лежит в конце файла.
+            fstream file(path, ios::binary | ios::in | ios::out);
+            string text_pool(15, ' ');
+            file.seekg(-static_cast<streamoff>(text_pool.size()), ios::end);
+            file.read(text_pool.data(), text_pool.size());
+            const int32_t damaged_id = 7;
+            file.seekp(216 + sizeof(int32_t) * (text_pool.find("gamma"s) / 5));
+            file.write(reinterpret_cast<const char*>(&damaged_id), sizeof(damaged_id));
+        }
+        const SearchServer damaged = SearchServer::LoadSnapshot(path);
+        filesystem::remove(path);
+        ASSERT_THROWS(damaged.FindTopDocuments("alpha gamma"s), runtime_error);
+        const auto found_docs = healthy.FindTopDocuments("alpha"s);
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT(abs(found_docs[0].relevance - 0.5 * log(2.0)) < EPSILON);
+    }
+}
+
+void TestFindTopDocumentsResultCount() {
+    SearchServer server{"in the"s};
+    for (int id = 1; id <= 8; ++id) {
+        string content = "cat"s;
+        for (int i = 0; i < id; ++i) {
+            content += " city"s;
+        }
+        // Релевантность убывает с ростом id.
+        (void) server.AddDocument(id, content, DocumentStatus::ACTUAL, {id});
+    }
+    (void) server.AddDocument(9, "dog in the city"s, DocumentStatus::ACTUAL, {9});
+
+    // По умолчанию возвращается не больше MAX_RESULT_DOCUMENT_COUNT документов.
+    const auto default_docs = server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(default_docs.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+
+    // Количество результатов задаётся при вызове, порядок совпадает с полной сортировкой.
+    const auto all_docs = server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 100);
+    ASSERT_EQUAL(all_docs.size(), 8u);
+    for (size_t i = 0; i < all_docs.size(); ++i) {
+        ASSERT_EQUAL(all_docs[i].id, static_cast<int>(i) + 1);
+    }
+    for (const size_t count : {0u, 1u, 3u, 7u, 8u}) {
+        for (const auto& found_docs : {server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, count),
+                                       server.FindTopDocuments(execution::par, "cat"s, DocumentStatus::ACTUAL, count)}) {
+            ASSERT_EQUAL(found_docs.size(), count);
+            for (size_t i = 0; i < count; ++i) {
+                ASSERT_EQUAL(found_docs[i].id, all_docs[i].id);
+            }
+        }
+    }
+    const auto even_docs = server.FindTopDocuments(
+        "cat"s, [](int document_id, DocumentStatus status, int rating) { return document_id % 2 == 0; }, 2);
+    ASSERT_EQUAL(even_docs.size(), 2u);
+    ASSERT_EQUAL(even_docs[0].id, 2);
+    ASSERT_EQUAL(even_docs[1].id, 4);
+}
+
+void TestFindTopDocumentsOffset() {
+    SearchServer server{"in the"s};
+    for (int id = 1; id <= 12; ++id) {
+        string content = "cat"s;
+        for (int i = 0; i < id; ++i) {
+            content += " city"s;
+        }
+        (void) server.AddDocument(id, content, DocumentStatus::ACTUAL, {id % 3});
+    }
+    (void) server.AddDocument(13, "dog in the city"s, DocumentStatus::ACTUAL, {0});
+    const auto all_docs = server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 100);
+    ASSERT_EQUAL(all_docs.size(), 12u);
+
+    // Страницы, найденные со смещением, совпадают с соответствующими частями полной выдачи.
+    for (const size_t page_size : {1u, 4u, 5u}) {
+        for (size_t offset = 0; offset < all_docs.size(); offset += page_size) {
+            for (const auto& page : {server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, page_size, offset),
+                                     server.FindTopDocuments(execution::par, "cat"s, DocumentStatus::ACTUAL, page_size, offset)}) {
+                ASSERT_EQUAL(page.size(), min(page_size, all_docs.size() - offset));
+                for (size_t i = 0; i < page.size(); ++i) {
+                    ASSERT_EQUAL(page[i].id, all_docs[offset + i].id);
+                }
+            }
+        }
+    }
+    ASSERT(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 5, 12).empty());
+    ASSERT(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 5, 100).empty());
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, static_cast<size_t>(-1), 10).size(), 2u);
+}
+
+void TestPaginator() {
+    const vector<int> numbers = {1, 2, 3, 4, 5, 6, 7};
+
+    // Последняя страница может быть неполной.
+    const auto pages = Paginate(numbers, 3);
+    ASSERT_EQUAL(pages.size(), 3u);
+    vector<vector<int>> pages_content;
+    for (const auto& page : pages) {
+        pages_content.emplace_back(page.begin(), page.end());
+    }
+    const vector<vector<int>> expected_content = {{1, 2, 3}, {4, 5, 6}, {7}};
+    ASSERT(pages_content == expected_content);
+
+    ASSERT_EQUAL(Paginate(numbers, 7).size(), 1u);
+    ASSERT_EQUAL(Paginate(numbers, 100).size(), 1u);
+    ASSERT_EQUAL(Paginate(vector<int>{}, 2).size(), 0u);
+    ASSERT_THROWS(Paginate(numbers, 0), invalid_argument);
+
+    // Страницы выводятся в поток так же, как контейнеры.
+    {
+        ostringstream output;
+        output << *Paginate(numbers, 2).begin();
+        ASSERT_EQUAL(output.str(), "1, 2"s);
+    }
+    {
+        SearchServer server;
+        (void) server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1, 2, 3});
+        const auto documents = server.FindTopDocuments("cat"s);
+        ostringstream output;
+        for (const auto& page : Paginate(documents, 1)) {
+            output << page;
+        }
+        ASSERT_EQUAL(output.str(), "{ document_id = 1, relevance = 0, rating = 2 }"s);
+    }
+}
+
+void TestRequestQueue() {
+    SearchServer server{"and in at"s};
+    RequestQueue request_queue(server);
+    (void) server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    (void) server.AddDocument(2, "curly dog and fancy collar"s, DocumentStatus::ACTUAL, {1, 2, 3});
+    (void) server.AddDocument(3, "big cat fancy collar "s, DocumentStatus::ACTUAL, {1, 2, 8});
+    (void) server.AddDocument(4, "big dog sparrow Eugene"s, DocumentStatus::ACTUAL, {1, 3, 2});
+    (void) server.AddDocument(5, "big dog sparrow Vasiliy"s, DocumentStatus::ACTUAL, {1, 1, 1});
+
+    // 1439 запросов с нулевым результатом.
+    for (int i = 0; i < 1439; ++i) {
+        (void) request_queue.AddFindRequest("empty request"s);
+    }
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1439);
+    // Все ещё 1439 запросов с нулевым результатом.
+    ASSERT_EQUAL(request_queue.AddFindRequest("curly dog"s).size(), 4u);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1439);
+    // Новые сутки, первый запрос удалён, 1438 запросов с нулевым результатом.
+    (void) request_queue.AddFindRequest("big collar"s);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1438);
+    // Первый запрос удалён, 1437 запросов с нулевым результатом.
+    (void) request_queue.AddFindRequest("sparrow"s);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1437);
+
+    // Запросы принимают те же аргументы, что и FindTopDocuments.
+    const auto banned_docs = request_queue.AddFindRequest("sparrow"s, DocumentStatus::BANNED);
+    ASSERT(banned_docs.empty());
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1437);
+    const auto even_docs = request_queue.AddFindRequest(
+        execution::par, "big"s, [](int document_id, DocumentStatus status, int rating) { return document_id % 2 == 0; }, 1);
+    ASSERT_EQUAL(even_docs.size(), 1u);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1436);
+    // Неуспешный запрос не учитывается в статистике.
+    ASSERT_THROWS(request_queue.AddFindRequest("cat --dog"s), invalid_argument);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1436);
+}
+
+void TestFindTopDocumentsWithExecutionPolicy() {
+    struct DocumentData {
+        int id;
+        string content;
+        vector<int> ratings;
+        DocumentStatus status;
+    };
+    vector<DocumentData> test_documents_data = {
+        {1, "cat in the city"s, {2, 3, 3}, DocumentStatus::ACTUAL},
+        {2, "dog in the city of Moscow"s, {4, 5, 3}, DocumentStatus::ACTUAL},
+        {3, "cat and dog in the city with mayor rat"s, {5, 5, 5}, DocumentStatus::ACTUAL},
+        {4, "cat in the city of Beijing of China country"s, {3, 3, 4}, DocumentStatus::BANNED},
+        {5, "big dog and small cat"s, {1, 1, 1}, DocumentStatus::ACTUAL},
+        {6, "fluffy cat with fluffy tail"s, {4, 4, 4}, DocumentStatus::ACTUAL},
+        {7, "rat in the city of Paris"s, {2, 2, 2}, DocumentStatus::ACTUAL},
+    };
+
+    SearchServer server{"in the"s};
+    for (const auto& [id, content, ratings, status] : test_documents_data) {
+        (void) server.AddDocument(id, content, status, ratings);
+    }
+
+    // Параллельная версия должна возвращать ровно то же, что и последовательная.
+    for (const string& query : {"cat"s, "fluffy cat dog"s, "cat dog -rat"s, "city -Moscow -Paris"s, "unknown"s}) {
+        const auto expected = server.FindTopDocuments(query);
+        for (const auto& found_docs : {server.FindTopDocuments(execution::seq, query),
+                                       server.FindTopDocuments(execution::par, query)}) {
+            ASSERT_EQUAL(found_docs.size(), expected.size());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_EQUAL(found_docs[i].id, expected[i].id);
+                ASSERT_EQUAL(found_docs[i].rating, expected[i].rating);
+                ASSERT(abs(found_docs[i].relevance - expected[i].relevance) < EPSILON);
+            }
+        }
+    }
+    // Фильтры по статусу и предикату работают и в параллельной версии.
+    {
+        const auto found_docs = server.FindTopDocuments(execution::par, "cat"s, DocumentStatus::BANNED);
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT_EQUAL(found_docs[0].id, 4);
+    }
+    {
+        const auto found_docs = server.FindTopDocuments(
+            execution::par, "city"s, [](int document_id, DocumentStatus status, int rating) {
+                return document_id % 2 == 0;
+            }
+        );
+        ASSERT_EQUAL(found_docs.size(), 2u);
+    }
+    ASSERT_THROWS(server.FindTopDocuments(execution::par, "cat --city"s), invalid_argument);
+}
+
+void TestProcessQueries() {
+    SearchServer server{"and with"s};
+    int id = 0;
+    for (const string& text : {
+            "funny pet and nasty rat"s,
+            "funny pet with curly hair"s,
+            "funny pet and not very nasty rat"s,
+            "pet with rat and rat and rat"s,
+            "nasty rat with curly hair"s,
+        }) {
+        server.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2});
+    }
+    const vector<string> queries = {
+        "nasty rat -not"s,
+        "not very funny nasty pet"s,
+        "curly hair"s,
+        "unknown"s,
+    };
+
+    // Результаты пакетной обработки совпадают с последовательными вызовами FindTopDocuments.
+    const auto documents_lists = ProcessQueries(server, queries);
+    ASSERT_EQUAL(documents_lists.size(), queries.size());
+    vector<int> expected_ids;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto expected = server.FindTopDocuments(queries[i]);
+        ASSERT_EQUAL(documents_lists[i].size(), expected.size());
+        for (size_t j = 0; j < expected.size(); ++j) {
+            ASSERT_EQUAL(documents_lists[i][j].id, expected[j].id);
+            expected_ids.push_back(expected[j].id);
+        }
+    }
+    ASSERT_EQUAL(documents_lists[3].size(), 0u);
+
+    // Объединённый результат перечисляет те же документы в порядке запросов.
+    const JoinedDocuments joined = ProcessQueriesJoined(server, queries);
+    ASSERT_EQUAL(joined.size(), expected_ids.size());
+    vector<int> joined_ids;
+    for (const Document& document : joined) {
+        joined_ids.push_back(document.id);
+    }
+    ASSERT_EQUAL(joined_ids, expected_ids);
+
+    ASSERT(ProcessQueriesJoined(server, {"unknown"s, "absent"s}).empty());
+    ASSERT_THROWS(ProcessQueries(server, {"rat"s, "cat --city"s}), invalid_argument);
+}
+
+void TestInverseDocumentFreqRefreshInterval() {
+    SearchServer server{"in the"s};
+    server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "dog in the city"s, DocumentStatus::ACTUAL, {1});
+
+    // По умолчанию IDF точен после каждого изменения индекса.
+    ASSERT(abs(server.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(2.0)) < EPSILON);
+    server.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(abs(server.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(3.0)) < EPSILON);
+    server.RemoveDocument(3);
+    ASSERT(abs(server.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(2.0)) < EPSILON);
+
+    // С интервалом IDF пересчитывается раз в 2 изменения, а в промежутке может устареть.
+    server.SetInverseDocumentFreqRefreshInterval(2);
+    ASSERT(abs(server.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(2.0)) < EPSILON);
+    server.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(abs(server.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(2.0)) < EPSILON);
+    // Новое слово получает IDF сразу при добавлении.
+    ASSERT(abs(server.FindTopDocuments("bird"s)[0].relevance - log(3.0)) < EPSILON);
+    server.AddDocument(4, "fish"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(abs(server.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(4.0)) < EPSILON);
+
+    // Копия сохраняет режим и кэшированные значения.
+    const SearchServer copy = server;
+    ASSERT(abs(copy.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(4.0)) < EPSILON);
+
+    // Возврат к точному режиму пересчитывает всё сразу.
+    server.RemoveDocument(4);
+    server.SetInverseDocumentFreqRefreshInterval(0);
+    ASSERT(abs(server.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(3.0)) < EPSILON);
+
+    // Пакет засчитывается по числу документов, но пересчитывает IDF не больше одного раза.
+    server.SetInverseDocumentFreqRefreshInterval(3);
+    server.AddDocuments({{5, "owl"s, DocumentStatus::ACTUAL, {1}}, {6, "fox"s, DocumentStatus::ACTUAL, {1}}});
+    ASSERT(abs(server.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(3.0)) < EPSILON);
+    server.AddDocuments({{7, "elk"s, DocumentStatus::ACTUAL, {1}}, {8, "yak"s, DocumentStatus::ACTUAL, {1}}});
+    ASSERT(abs(server.FindTopDocuments("cat"s)[0].relevance - 0.5 * log(7.0)) < EPSILON);
+    ASSERT_THROWS(server.SetInverseDocumentFreqRefreshInterval(-1), invalid_argument);
+}
+
+void TestQueryCache() {
+    SearchServer server{"in the"s};
+    server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "dog in the city"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "cat and dog"s, DocumentStatus::BANNED, {3});
+
+    // Без включения кэш не используется.
+    (void) server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(server.GetQueryCacheStats().hit_count + server.GetQueryCacheStats().miss_count, 0u);
+
+    server.EnableQueryCache(2);
+    const auto expected = server.FindTopDocuments("cat city -dog"s);
+    ASSERT_EQUAL(server.GetQueryCacheStats().miss_count, 1u);
+
+    // Запросы, отличающиеся порядком, повторами и стоп-словами, попадают в кэш.
+    const auto cached = server.FindTopDocuments("city in cat -dog cat"s);
+    ASSERT_EQUAL(server.GetQueryCacheStats().hit_count, 1u);
+    ASSERT_EQUAL(cached.size(), expected.size());
+    ASSERT_EQUAL(cached[0].id, expected[0].id);
+    ASSERT(abs(cached[0].relevance - expected[0].relevance) < EPSILON);
+
+    // Статус, количество и смещение входят в ключ.
+    ASSERT_EQUAL(server.FindTopDocuments("cat city -dog"s, DocumentStatus::BANNED).size(), 0u);
+    ASSERT_EQUAL(server.FindTopDocuments("cat city -dog"s, DocumentStatus::ACTUAL, 1, 1).size(), 0u);
+    ASSERT_EQUAL(server.GetQueryCacheStats().miss_count, 3u);
+
+    // Запросы с произвольным фильтром кэш не затрагивают.
+    (void) server.FindTopDocuments("cat city -dog"s, [](int, DocumentStatus, int) { return true; });
+    ASSERT_EQUAL(server.GetQueryCacheStats().hit_count, 1u);
+    ASSERT_EQUAL(server.GetQueryCacheStats().miss_count, 3u);
+
+    // Вытесняется давно не использованный запрос.
+    (void) server.FindTopDocuments("cat city -dog"s);
+    ASSERT_EQUAL(server.GetQueryCacheStats().miss_count, 4u);
+    (void) server.FindTopDocuments("cat city -dog"s, DocumentStatus::ACTUAL, 1, 1);
+    ASSERT_EQUAL(server.GetQueryCacheStats().hit_count, 2u);
+
+    // Изменение индекса сбрасывает кэш.
+    server.AddDocument(4, "cat"s, DocumentStatus::ACTUAL, {4});
+    ASSERT_EQUAL(server.FindTopDocuments("cat city -dog"s).size(), 2u);
+    ASSERT_EQUAL(server.GetQueryCacheStats().miss_count, 5u);
+    server.RemoveDocument(4);
+    ASSERT_EQUAL(server.FindTopDocuments("cat city -dog"s).size(), 1u);
+    ASSERT_EQUAL(server.GetQueryCacheStats().miss_count, 6u);
+
+    // Копия получает собственный пустой кэш той же ёмкости.
+    const SearchServer copy = server;
+    (void) copy.FindTopDocuments("cat city -dog"s);
+    ASSERT_EQUAL(copy.GetQueryCacheStats().miss_count, 1u);
+
+    server.EnableQueryCache(0);
+    (void) server.FindTopDocuments("cat city -dog"s);
+    ASSERT_EQUAL(server.GetQueryCacheStats().miss_count, 0u);
+}
+
+void TestSparseDocumentIdsAfterRemoval() {
+    SearchServer server{"in the"s};
+    (void) server.AddDocument(1'000'000'000, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    (void) server.AddDocument(7, "cat and dog"s, DocumentStatus::BANNED, {2});
+    (void) server.AddDocument(300, "dog in the park"s, DocumentStatus::ACTUAL, {3});
+    server.RemoveDocument(7);
+    (void) server.AddDocument(7, "cat cat park"s, DocumentStatus::ACTUAL, {4});
+
+    // Фильтр и результаты получают внешние id, удалённый документ не находится.
+    vector<int> filtered_ids;
+    const auto found_docs = server.FindTopDocuments("cat -dog"s, [&filtered_ids](int id, DocumentStatus status, int rating) {
+        filtered_ids.push_back(id);
+        return status == DocumentStatus::ACTUAL && rating > 0;
+    });
+    ASSERT_EQUAL(found_docs.size(), 2u);
+    ASSERT_EQUAL(found_docs[0].id, 7);
+    ASSERT_EQUAL(found_docs[0].rating, 4);
+    ASSERT_EQUAL(found_docs[1].id, 1'000'000'000);
+    sort(filtered_ids.begin(), filtered_ids.end());
+    ASSERT_EQUAL(filtered_ids, vector<int>({7, 1'000'000'000}));
+
+    // Параллельный поиск по диапазонам id совпадает с последовательным.
+    for (const string& query : {"cat"s, "park -cat"s, "cat dog park"s, "cat -park"s}) {
+        const auto seq_docs = server.FindTopDocuments(execution::seq, query);
+        const auto par_docs = server.FindTopDocuments(execution::par, query);
+        ASSERT_EQUAL(seq_docs.size(), par_docs.size());
+        for (size_t i = 0; i < seq_docs.size(); ++i) {
+            ASSERT_EQUAL(seq_docs[i].id, par_docs[i].id);
+            ASSERT(abs(seq_docs[i].relevance - par_docs[i].relevance) < EPSILON);
+        }
+    }
+
+    const auto [words, status] = server.MatchDocument("cat dog park"s, 7);
+    ASSERT(words == vector<string_view>({"cat"sv, "park"sv}));
+    ASSERT_THROWS(server.MatchDocument("cat"s, 8), out_of_range);
+    ASSERT_EQUAL(server.GetWordFrequencies(7).size(), 2u);
+}
+
+void TestCompressedPostings() {
+    SearchServer server{"in the"s};
+    mt19937 generator;
+    const vector<string> words = {"cat"s, "dog"s, "park"s, "city"s, "tail"s, "in"s};
+    for (int id = 0; id < 1'000; ++id) {
+        string text;
+        for (int i = 0; i < 6; ++i) {
+            text += words[generator() % words.size()] + ' ';
+        }
+        (void) server.AddDocument(id * 3, text, static_cast<DocumentStatus>(id % 2), {id % 7});
+    }
+    SearchServer compressed_server = server;
+    compressed_server.SetPostingsCompression(true);
+    ASSERT(compressed_server.GetIndexStats().memory_usage < server.GetIndexStats().memory_usage);
+    // Прямой индекс сжатого сервера строится только по требованию.
+    ASSERT(server.GetIndexStats().forward_index_memory_usage > 0u);
+    ASSERT_EQUAL(compressed_server.GetIndexStats().forward_index_memory_usage, 0u);
+
+    // Сжатие не меняет ни результаты, ни частоты слов, ни сопоставление документов.
+    const auto to_tuples = [](const vector<Document>& documents) {
+        vector<tuple<int, double, int>> result;
+        for (const Document& document : documents) {
+            result.emplace_back(document.id, document.relevance, document.rating);
+        }
+        return result;
+    };
+    const auto check_same = [&]() {
+        for (const string& query : {"cat"s, "cat dog -park"s, "tail city -in"s, "dog park tail -cat"s}) {
+            for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT}) {
+                ASSERT(to_tuples(compressed_server.FindTopDocuments(execution::seq, query, status, 100))
+                       == to_tuples(server.FindTopDocuments(execution::seq, query, status, 100)));
+                ASSERT(to_tuples(compressed_server.FindTopDocuments(execution::par, query, status, 100))
+                       == to_tuples(server.FindTopDocuments(execution::par, query, status, 100)));
+            }
+        }
+        for (const int id : server) {
+            ASSERT(compressed_server.GetWordFrequencies(id) == server.GetWordFrequencies(id));
+            ASSERT(compressed_server.MatchDocument("cat park -city"s, id) == server.MatchDocument("cat park -city"s, id));
+        }
+    };
+    check_same();
+
+    // Изменения индекса при включённом сжатии.
+    for (SearchServer* target : {&server, &compressed_server}) {
+        target->RemoveDocument(300);
+        target->RemoveDocument(1'500);
+        (void) target->AddDocument(5'000, "cat cat cat bird"s, DocumentStatus::ACTUAL, {5});
+    }
+    check_same();
+
+    // Снимок сжатого индекса загружается несжатым с теми же результатами.
+    const string path = (filesystem::temp_directory_path() / "search_server_compressed_test.snapshot"s).string();
+    compressed_server.SaveSnapshot(path);
+    const SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+    filesystem::remove(path);
+    ASSERT(to_tuples(loaded_server.FindTopDocuments("cat bird -dog"s)) == to_tuples(server.FindTopDocuments("cat bird -dog"s)));
+
+    compressed_server.SetPostingsCompression(false);
+    check_same();
+}
+
+void TestTopDocumentQueryEvaluation() {
+    SearchServer server{"in the"s};
+    mt19937 generator(7);
+    // Частоты слов убывают с номером слова, как в естественном языке.
+    vector<string> words;
+    vector<double> weights;
+    for (int i = 0; i < 40; ++i) {
+        words.push_back("w"s + to_string(i));
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<int> word_distribution(weights.begin(), weights.end());
+    const auto generate_text = [&](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += words[word_distribution(generator)] + ' ';
+        }
+        return text;
+    };
+    // Рейтинги различны, так что порядок документов с равной релевантностью однозначен.
+    for (int id = 0; id < 3'000; ++id) {
+        (void) server.AddDocument(id, generate_text(3 + id % 10), static_cast<DocumentStatus>(id % 3), {id});
+    }
+    vector<string> queries;
+    for (int i = 0; i < 200; ++i) {
+        string query = generate_text(1 + i % 5);
+        for (int j = 0; j < i % 3; ++j) {
+            query += '-' + words[uniform_int_distribution<int>(0, words.size() - 1)(generator)] + ' ';
+        }
+        queries.push_back(query);
+    }
+
+    const auto to_tuples = [](const vector<Document>& documents) {
+        vector<tuple<int, double, int>> result;
+        for (const Document& document : documents) {
+            result.emplace_back(document.id, document.relevance, document.rating);
+        }
+        return result;
+    };
+    // Обход по документам и WAND возвращают то же ранжирование, что и полный перебор,
+    // с фильтрами и смещением.
+    const auto check_same = [&](const SearchServer& exhaustive_server, SearchServer server) {
+        for (const QueryEvaluation evaluation : {QueryEvaluation::DOCUMENT_AT_A_TIME, QueryEvaluation::WAND}) {
+            server.SetQueryEvaluation(evaluation);
+            for (const string& query : queries) {
+                ASSERT(to_tuples(server.FindTopDocuments(query)) == to_tuples(exhaustive_server.FindTopDocuments(query)));
+                ASSERT(to_tuples(server.FindTopDocuments(query, DocumentStatus::BANNED, 3, 4))
+                       == to_tuples(exhaustive_server.FindTopDocuments(query, DocumentStatus::BANNED, 3, 4)));
+                const auto filter = [](int document_id, DocumentStatus status, int rating) {
+                    return document_id % 7 != 0;
+                };
+                ASSERT(to_tuples(server.FindTopDocuments(query, filter, 20))
+                       == to_tuples(exhaustive_server.FindTopDocuments(query, filter, 20)));
+                ASSERT(server.FindTopDocuments(query, filter, 0).empty());
+            }
+        }
+    };
+    check_same(server, server);
+
+    SearchServer compressed_server = server;
+    compressed_server.SetPostingsCompression(true);
+    check_same(server, compressed_server);
+
+    for (int id = 0; id < 3'000; id += 11) {
+        server.RemoveDocument(id);
+    }
+    (void) server.AddDocument(5'000, "w39 w39 w39"s, DocumentStatus::ACTUAL, {5'000});
+    check_same(server, server);
+
+    // Границы частот слов сохраняются в снимке.
+    const string path = (filesystem::temp_directory_path() / "search_server_wand_test.snapshot"s).string();
+    server.SaveSnapshot(path);
+    const SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+    filesystem::remove(path);
+    check_same(server, loaded_server);
+
+    // Обход по документам оценивает только прошедшие фильтр документы, а отсечение
+    // ещё меньше записей.
+    SearchServer document_at_a_time_server = server;
+    document_at_a_time_server.SetQueryEvaluation(QueryEvaluation::DOCUMENT_AT_A_TIME);
+    SearchServer wand_server = server;
+    wand_server.SetQueryEvaluation(QueryEvaluation::WAND);
+    SearchServer exhaustive_server = server;
+    for (const string& query : queries) {
+        (void) document_at_a_time_server.FindTopDocuments(query);
+        (void) wand_server.FindTopDocuments(query);
+        (void) exhaustive_server.FindTopDocuments(query);
+    }
+    const QueryEvaluationStats document_at_a_time_stats = document_at_a_time_server.GetQueryEvaluationStats();
+    const QueryEvaluationStats wand_stats = wand_server.GetQueryEvaluationStats();
+    const QueryEvaluationStats exhaustive_stats = exhaustive_server.GetQueryEvaluationStats();
+    ASSERT_EQUAL(document_at_a_time_stats.query_count, queries.size());
+    ASSERT_EQUAL(wand_stats.query_count, queries.size());
+    ASSERT_EQUAL(exhaustive_stats.query_count, queries.size());
+    ASSERT(document_at_a_time_stats.scored_posting_count < exhaustive_stats.scored_posting_count);
+    ASSERT(wand_stats.scored_posting_count < document_at_a_time_stats.scored_posting_count);
+}
+
+void TestTopDocumentCandidates() {
+    // При равной релевантности кандидатов не больше, чем запрошено: лучшие
+    // по рейтингу, а при равном рейтинге с меньшими id.
+    TopDocumentCandidates candidates(5, pmr::get_default_resource());
+    for (int id = 1'000; id > 0; --id) {
+        candidates.Add({id, 0.5, id % 3 == 0 ? 1 : 0});
+    }
+    pmr::vector<Document> documents = candidates.Extract();
+    vector<int> ids;
+    for (const Document& document : documents) {
+        ids.push_back(document.id);
+    }
+    sort(ids.begin(), ids.end());
+    ASSERT_EQUAL(ids, vector<int>({3, 6, 9, 12, 15}));
+
+    // Более релевантные документы сохраняются, места остаются равным k-му.
+    TopDocumentCandidates mixed_candidates(3, pmr::get_default_resource());
+    for (int id = 0; id < 100; ++id) {
+        mixed_candidates.Add({id, id == 50 ? 0.9 : 0.5 + EPSILON / 10 * (id % 2), 0});
+    }
+    ids.clear();
+    for (const Document& document : mixed_candidates.Extract()) {
+        ids.push_back(document.id);
+    }
+    sort(ids.begin(), ids.end());
+    ASSERT_EQUAL(ids, vector<int>({0, 1, 50}));
+}
+
+void TestDocumentFilter() {
+    SearchServer server{"in the"s};
+    mt19937 generator(11);
+    uniform_int_distribution<int> word_distribution(0, 30);
+    const auto generate_text = [&](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += "w"s + to_string(word_distribution(generator)) + ' ';
+        }
+        return text;
+    };
+    // Рейтинги различны, так что порядок документов с равной релевантностью однозначен.
+    for (int id = 0; id < 2'000; ++id) {
+        (void) server.AddDocument(id * 3, generate_text(2 + id % 7), static_cast<DocumentStatus>(id % 4),
+                                  {id * 7'919 % 2'003 - 1'000});
+    }
+    for (int id = 0; id < 2'000; id += 13) {
+        server.RemoveDocument(id * 3);
+    }
+    vector<string> queries;
+    for (int i = 0; i < 50; ++i) {
+        queries.push_back(generate_text(1 + i % 4) + (i % 3 == 0 ? "-w"s + to_string(i % 31) : ""s));
+    }
+
+    vector<DocumentFilter> filters(7);
+    filters[0].status = DocumentStatus::BANNED;
+    filters[1].min_rating = -300;
+    filters[1].max_rating = 300;
+    filters[2].status = DocumentStatus::ACTUAL;
+    filters[2].min_rating = 0;
+    filters[3].max_rating = -500;
+    filters[3].document_ids = vector<int>{};
+    for (int id = 0; id < 6'000; id += 7) {
+        filters[3].document_ids->push_back(id);
+    }
+    filters[4].min_rating = 10;
+    filters[4].max_rating = -10;
+    filters[5].min_rating = -900;
+    const auto as_predicate = [](const DocumentFilter& filter) {
+        return [&filter](int document_id, DocumentStatus status, int rating) {
+            return (!filter.status || *filter.status == status)
+                && (!filter.min_rating || *filter.min_rating <= rating)
+                && (!filter.max_rating || rating <= *filter.max_rating)
+                && (!filter.document_ids || count(filter.document_ids->begin(), filter.document_ids->end(), document_id) > 0);
+        };
+    };
+    const auto to_tuples = [](const vector<Document>& documents) {
+        vector<tuple<int, double, int>> result;
+        for (const Document& document : documents) {
+            result.emplace_back(document.id, document.relevance, document.rating);
+        }
+        return result;
+    };
+    // Фильтр на столбцах документов возвращает то же, что и равносильный предикат,
+    // при любом способе обхода запроса.
+    const auto check_same = [&](SearchServer checked_server) {
+        for (const QueryEvaluation evaluation : {QueryEvaluation::EXHAUSTIVE, QueryEvaluation::DOCUMENT_AT_A_TIME,
+                                                 QueryEvaluation::WAND}) {
+            checked_server.SetQueryEvaluation(evaluation);
+            for (const string& query : queries) {
+                for (const DocumentFilter& filter : filters) {
+                    const auto expected = to_tuples(server.FindTopDocuments(query, as_predicate(filter), 10, 2));
+                    ASSERT(to_tuples(checked_server.FindTopDocuments(query, filter, 10, 2)) == expected);
+                    ASSERT(to_tuples(checked_server.FindTopDocuments(execution::par, query, filter, 10, 2)) == expected);
+                }
+            }
+        }
+    };
+    check_same(server);
+
+    (void) server.AddDocument(10'000, "w1 w2 w3"s, DocumentStatus::BANNED, {30});
+    check_same(server);
+
+    const string path = (filesystem::temp_directory_path() / "search_server_filter_test.snapshot"s).string();
+    server.SaveSnapshot(path);
+    const SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+    filesystem::remove(path);
+    check_same(loaded_server);
+
+    ShardedSearchServer sharded_server("in the"s, 3);
+    for (const int document_id : server) {
+        const auto& word_freqs = server.GetWordFrequencies(document_id);
+        string text;
+        for (const auto& [word, _] : word_freqs) {
+            text += string(word) + ' ';
+        }
+        (void) sharded_server.AddDocument(document_id, text, static_cast<DocumentStatus>(document_id % 4), {document_id});
+    }
+    for (const DocumentFilter& filter : filters) {
+        ASSERT(to_tuples(sharded_server.FindTopDocuments("w1 w5 w9"s, filter))
+               == to_tuples(sharded_server.FindTopDocuments("w1 w5 w9"s, as_predicate(filter))));
+    }
+}
+
+void TestIngestDocuments() {
+    vector<NewDocument> documents;
+    vector<string> texts;
+    for (int i = 0; i < 500; ++i) {
+        texts.push_back("w"s + to_string(i % 17) + " w"s + to_string(i % 5) + " in the w"s + to_string(i));
+    }
+    string records;
+    for (int i = 0; i < 500; ++i) {
+        const DocumentStatus status = static_cast<DocumentStatus>(i % 4);
+        vector<int> ratings;
+        for (int j = 0; j < i % 3; ++j) {
+            ratings.push_back(i - j * 7);
+        }
+        documents.push_back({i * 2, texts[i], status, ratings});
+        records += to_string(i * 2) + '\t';
+        ostringstream status_name;
+        status_name << status;
+        records += status_name.str() + '\t';
+        for (const int rating : ratings) {
+            records += to_string(rating) + ' ';
+        }
+        records += '\t' + texts[i] + (i % 10 == 0 ? "\r\n\n"s : "\n"s);
+    }
+    SearchServer expected_server{"in the"s};
+    expected_server.AddDocuments(documents);
+    const auto check_same = [&](const SearchServer& server) {
+        ASSERT_EQUAL(server.GetDocumentCount(), expected_server.GetDocumentCount());
+        ASSERT(equal(server.begin(), server.end(), expected_server.begin(), expected_server.end()));
+        for (const int document_id : expected_server) {
+            ASSERT(server.GetWordFrequencies(document_id) == expected_server.GetWordFrequencies(document_id));
+        }
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+            const auto found = server.FindTopDocuments("w3 w4"s, status, 20);
+            const auto expected = expected_server.FindTopDocuments("w3 w4"s, status, 20);
+            ASSERT_EQUAL(found.size(), expected.size());
+            for (size_t i = 0; i < found.size(); ++i) {
+                ASSERT_EQUAL(found[i].id, expected[i].id);
+                ASSERT_EQUAL(found[i].rating, expected[i].rating);
+            }
+        }
+    };
+
+    // Маленькие порции проверяют разрезание входа по концам строк.
+    IngestOptions options;
+    options.chunk_size = 100;
+    options.queue_capacity = 2;
+    options.worker_count = 3;
+    {
+        SearchServer server{"in the"s};
+        istringstream input(records);
+        const IngestStats stats = IngestDocuments(server, input, options);
+        ASSERT_EQUAL(stats.document_count, documents.size());
+        ASSERT_EQUAL(stats.byte_count, records.size());
+        check_same(server);
+    }
+    const string path = (filesystem::temp_directory_path() / "search_server_ingest_test.tsv"s).string();
+    {
+        ofstream(path, ios::binary) << records;
+        SearchServer server{"in the"s};
+        ASSERT_EQUAL(IngestDocuments(server, path, options).document_count, documents.size());
+        check_same(server);
+        SearchServer default_options_server{"in the"s};
+        (void) IngestDocuments(default_options_server, path);
+        check_same(default_options_server);
+    }
+
+    // Документы до ошибочной записи добавляются, ошибка пробрасывается.
+    for (const string& bad_record : {"7\tACTUAL\t1\tcat\n1\tPENDING\t\tdog\n"s,
+                                     "7\tACTUAL\t1\tcat\n1\tACTUAL\tx\tdog\n"s,
+                                     "7\tACTUAL\t1\tcat\n1 ACTUAL dog\n"s,
+                                     "7\tACTUAL\t1\tcat\n7\tACTUAL\t\tdog\n"s}) {
+        SearchServer server;
+        const size_t middle = records.find('\n', records.size() / 2) + 1;
+        istringstream input(records.substr(0, middle) + bad_record + records.substr(middle));
+        ASSERT_THROWS(IngestDocuments(server, input, options), invalid_argument);
+        ASSERT(server.GetDocumentCount() > 0);
+        ASSERT(server.FindTopDocuments("cat"s).size() == 1);
+        ASSERT(server.FindTopDocuments("dog"s).empty());
+        ASSERT(server.GetDocumentCount() < static_cast<int>(documents.size()));
+    }
+
+    ofstream(path, ios::binary | ios::trunc);
+    SearchServer empty_server;
+    ASSERT_EQUAL(IngestDocuments(empty_server, path).document_count, 0u);
+    filesystem::remove(path);
+    ASSERT_THROWS(IngestDocuments(empty_server, path), exception);
+}
+
+void TestShardedSearchServer() {
+    ASSERT_THROWS(ShardedSearchServer("in the"s, 0), invalid_argument);
+    SearchServer server{"in the"s};
+    ShardedSearchServer sharded_server{"in the"s, 3};
+    mt19937 generator;
+    const vector<string> words = {"cat"s, "dog"s, "park"s, "city"s, "tail"s, "bird"s, "in"s};
+    vector<string> texts;
+    for (int id = 0; id < 300; ++id) {
+        string text;
+        for (int i = 0; i < 5; ++i) {
+            text += words[generator() % words.size()] + ' ';
+        }
+        texts.push_back(text);
+    }
+    vector<NewDocument> documents;
+    for (int id = 0; id < 300; ++id) {
+        (void) server.AddDocument(id * 7, texts[id], static_cast<DocumentStatus>(id % 3), {id});
+        if (id < 200) {
+            documents.push_back({id * 7, texts[id], static_cast<DocumentStatus>(id % 3), {id}});
+        } else {
+            sharded_server.AddDocument(id * 7, texts[id], static_cast<DocumentStatus>(id % 3), {id});
+        }
+    }
+    sharded_server.AddDocuments(documents);
+    server.RemoveDocument(14);
+    sharded_server.RemoveDocument(14);
+    ASSERT_EQUAL(sharded_server.GetDocumentCount(), server.GetDocumentCount());
+    ASSERT(sharded_server.GetShardByIndex(0).GetDocumentCount() > 0);
+
+    // Глобальный IDF даёт те же документы с той же релевантностью, что и один сервер.
+    const auto to_tuples = [](const vector<Document>& documents) {
+        vector<tuple<int, double, int>> result;
+        for (const Document& document : documents) {
+            result.emplace_back(document.id, document.relevance, document.rating);
+        }
+        return result;
+    };
+    for (const string& query : {"cat"s, "cat dog -park"s, "tail bird -in"s, "dog park tail -cat"s}) {
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+            ASSERT(to_tuples(sharded_server.FindTopDocuments(query, status)) == to_tuples(server.FindTopDocuments(query, status)));
+            ASSERT(to_tuples(sharded_server.FindTopDocuments(query, status, 10, 7))
+                   == to_tuples(server.FindTopDocuments(query, status, 10, 7)));
+        }
+        const auto odd_rating = [](int id, DocumentStatus status, int rating) {
+            return rating % 2 == 1;
+        };
+        ASSERT(to_tuples(sharded_server.FindTopDocuments(query, odd_rating)) == to_tuples(server.FindTopDocuments(query, odd_rating)));
+    }
+    ASSERT(sharded_server.MatchDocument("cat dog park"s, 21) == server.MatchDocument("cat dog park"s, 21));
+    ASSERT_THROWS(sharded_server.MatchDocument("cat"s, 14), out_of_range);
+    ASSERT_THROWS(sharded_server.FindTopDocuments("cat --dog"s), invalid_argument);
+
+    // Ошибка в пакете не мешает добавить документы до неё, повторяется первая ошибка.
+    ASSERT_THROWS(sharded_server.AddDocuments({{1'000, "cat"s, DocumentStatus::ACTUAL, {1}},
+                                               {7, "cat"s, DocumentStatus::ACTUAL, {1}},
+                                               {-1, "cat"s, DocumentStatus::ACTUAL, {1}}}), invalid_argument);
+    ASSERT_EQUAL(get<1>(sharded_server.MatchDocument("cat"s, 1'000)), DocumentStatus::ACTUAL);
+}
+
+void TestAddDocuments() {
+    SearchServer server{"in the"s};
+    SearchServer batch_server{"in the"s};
+    mt19937 generator;
+    const vector<string> words = {"cat"s, "dog"s, "park"s, "city"s, "tail"s, "bird"s, "in"s};
+    vector<string> texts;
+    for (int i = 0; i < 500; ++i) {
+        string text;
+        for (int j = 0; j < 6; ++j) {
+            text += words[generator() % words.size()] + ' ';
+        }
+        texts.push_back(text);
+    }
+    (void) server.AddDocument(1'000, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    (void) batch_server.AddDocument(1'000, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    vector<NewDocument> documents;
+    for (int i = 0; i < 500; ++i) {
+        const int id = (i * 7919) % 500;
+        (void) server.AddDocument(id, texts[i], static_cast<DocumentStatus>(i % 3), {i, 1});
+        documents.push_back({id, texts[i], static_cast<DocumentStatus>(i % 3), {i, 1}});
+    }
+    batch_server.AddDocuments(documents);
+
+    // Пакетное добавление неотличимо от последовательного.
+    const auto to_tuples = [](const vector<Document>& documents) {
+        vector<tuple<int, double, int>> result;
+        for (const Document& document : documents) {
+            result.emplace_back(document.id, document.relevance, document.rating);
+        }
+        return result;
+    };
+    ASSERT(vector<int>(batch_server.begin(), batch_server.end()) == vector<int>(server.begin(), server.end()));
+    for (const string& query : {"cat"s, "cat dog -park"s, "tail bird -in"s, "dog park tail -cat"s}) {
+        ASSERT(to_tuples(batch_server.FindTopDocuments(query)) == to_tuples(server.FindTopDocuments(query)));
+        ASSERT(to_tuples(batch_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED))
+               == to_tuples(server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED)));
+    }
+    for (const int id : server) {
+        ASSERT(batch_server.GetWordFrequencies(id) == server.GetWordFrequencies(id));
+    }
+
+    // Документы до ошибочного добавляются, после него — нет.
+    const auto check_rejected_batch = [&batch_server](const vector<NewDocument>& batch, int added_count) {
+        const int document_count = batch_server.GetDocumentCount();
+        ASSERT_THROWS(batch_server.AddDocuments(batch), invalid_argument);
+        ASSERT_EQUAL(batch_server.GetDocumentCount(), document_count + added_count);
+        ASSERT_EQUAL(batch_server.GetDocumentId(document_count + added_count - 1), batch[added_count - 1].id);
+    };
+    check_rejected_batch({{2'000, "sparrow"s, DocumentStatus::ACTUAL, {}}, {2'001, "sparrow"s, DocumentStatus::ACTUAL, {}},
+                          {2'000, "sparrow"s, DocumentStatus::ACTUAL, {}}}, 2);
+    check_rejected_batch({{2'002, "owl"s, DocumentStatus::ACTUAL, {}}, {2'003, "bird \x12"s, DocumentStatus::ACTUAL, {}},
+                          {2'004, "owl"s, DocumentStatus::ACTUAL, {}}}, 1);
+    check_rejected_batch({{2'005, "owl"s, DocumentStatus::ACTUAL, {}}, {-1, "owl"s, DocumentStatus::ACTUAL, {}}}, 1);
+    ASSERT_EQUAL(batch_server.FindTopDocuments("owl"s).size(), 2u);
+    ASSERT_EQUAL(batch_server.FindTopDocuments("sparrow"s).size(), 2u);
+    (void) batch_server.AddDocument(2'004, "owl"s, DocumentStatus::ACTUAL, {});
+
+    // Пакет в сжатый индекс.
+    batch_server.SetPostingsCompression(true);
+    batch_server.AddDocuments({{3'000, "cat cat owl"s, DocumentStatus::ACTUAL, {5}}, {3'001, "heron"s, DocumentStatus::ACTUAL, {6}}});
+    ASSERT_EQUAL(batch_server.FindTopDocuments("heron"s).size(), 1u);
+    ASSERT_EQUAL(batch_server.FindTopDocuments("owl"s).size(), 4u);
+    ASSERT(abs(batch_server.GetWordFrequencies(3'000).at("cat"s) - 2.0 / 3) < EPSILON);
+}
+
+void TestConcurrentSearchServer() {
+    SearchServer initial_server{"in the"s};
+    (void) initial_server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    ConcurrentSearchServer server(move(initial_server));
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 1u);
+
+    // Изменения не видны до публикации.
+    server.AddDocument(2, "cat and dog"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocuments({{3, "dog"s, DocumentStatus::ACTUAL, {3}}, {4, "cat"s, DocumentStatus::BANNED, {4}}});
+    ASSERT_THROWS(server.AddDocument(2, "dog"s, DocumentStatus::ACTUAL, {}), invalid_argument);
+    ASSERT_EQUAL(server.GetDocumentCount(), 1);
+    server.Publish();
+    ASSERT_EQUAL(server.GetDocumentCount(), 4);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 2u);
+
+    // Читатель видит неизменное поколение, публикация ждёт, пока он его не отпустит.
+    shared_ptr<const SearchServer> generation = server.GetPublished();
+    server.RemoveDocument(1);
+    thread publisher([&server]() {
+        server.Publish();
+    });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    ASSERT_EQUAL(generation->FindTopDocuments("cat"s).size(), 2u);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 1u);
+    generation.reset();
+    publisher.join();
+
+    // Оба экземпляра индекса проходят одни и те же изменения.
+    server.AddDocument(5, "city cat"s, DocumentStatus::ACTUAL, {5});
+    server.Publish();
+    server.Publish();
+    ASSERT_EQUAL(server.GetDocumentCount(), 4);
+    ASSERT(server.MatchDocument("cat city"s, 5) == tuple(vector<string_view>{"cat"sv, "city"sv}, DocumentStatus::ACTUAL));
+    ASSERT_THROWS(server.MatchDocument("cat"s, 1), out_of_range);
+
+    // Поиск во время записи видит только целые поколения.
+    atomic<bool> is_writing = true;
+    thread writer([&server, &is_writing]() {
+        for (int id = 10; id < 210; ++id) {
+            server.AddDocument(id, "bird"s, DocumentStatus::ACTUAL, {id});
+            if (id % 20 == 0) {
+                server.Publish();
+            }
+        }
+        server.Publish();
+        is_writing = false;
+    });
+    size_t previous_count = 0;
+    while (is_writing) {
+        const shared_ptr<const SearchServer> published = server.GetPublished();
+        const size_t count = published->FindTopDocuments("bird"s, DocumentStatus::ACTUAL, 1'000).size();
+        ASSERT(count >= previous_count);
+        ASSERT_EQUAL(static_cast<int>(count), published->GetDocumentCount() - 4);
+        previous_count = count;
+    }
+    writer.join();
+    ASSERT_EQUAL(server.FindTopDocuments("bird"s, DocumentStatus::ACTUAL, 1'000).size(), 200u);
+
+    // Пакет повторяется на другом поколении пакетом, так что при пересчёте IDF
+    // раз в несколько изменений оба поколения дают одинаковые результаты.
+    SearchServer stale_server{"in the"s};
+    (void) stale_server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    stale_server.SetInverseDocumentFreqRefreshInterval(2);
+    SearchServer expected_server = stale_server;
+    ConcurrentSearchServer stale_concurrent_server(move(stale_server));
+    const auto check_same_relevance = [&]() {
+        const auto found_docs = stale_concurrent_server.FindTopDocuments("cat"s);
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT(abs(found_docs[0].relevance - expected_server.FindTopDocuments("cat"s)[0].relevance) < EPSILON);
+    };
+    const vector<NewDocument> batch = {{2, "dog"s, DocumentStatus::ACTUAL, {2}}, {3, "bird"s, DocumentStatus::ACTUAL, {3}},
+                                       {4, "fish"s, DocumentStatus::ACTUAL, {4}}};
+    expected_server.AddDocuments(batch);
+    stale_concurrent_server.AddDocuments(batch);
+    stale_concurrent_server.Publish();
+    check_same_relevance();
+    expected_server.AddDocument(5, "owl"s, DocumentStatus::ACTUAL, {5});
+    stale_concurrent_server.AddDocument(5, "owl"s, DocumentStatus::ACTUAL, {5});
+    for (int i = 0; i < 3; ++i) {
+        stale_concurrent_server.Publish();
+        check_same_relevance();
+    }
+}
+
+// Считает выделения памяти, передавая их ресурсу по умолчанию.
+class CountingMemoryResource : public pmr::memory_resource {
+public:
+    size_t allocation_count = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocation_count;
+        return pmr::get_default_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        pmr::get_default_resource()->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+void TestMemoryResource() {
+    CountingMemoryResource memory_resource;
+    SearchServer server{"in the"s, &memory_resource};
+    SearchServer default_server{"in the"s};
+    for (SearchServer* target : {&server, &default_server}) {
+        (void) target->AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+        (void) target->AddDocument(2, "dog in the city"s, DocumentStatus::ACTUAL, {2});
+        (void) target->AddDocuments({{3, "cat and dog"s, DocumentStatus::ACTUAL, {3}}});
+        target->RemoveDocument(execution::par, 2);
+    }
+    ASSERT(server.GetMemoryResource() == &memory_resource);
+    ASSERT(memory_resource.allocation_count > 0);
+
+    // Поиск не выделяет память из ресурса индекса.
+    const size_t index_allocation_count = memory_resource.allocation_count;
+    const auto found_docs = server.FindTopDocuments("cat city -dog"s);
+    (void) server.FindTopDocuments(execution::par, "cat city"s);
+    (void) server.MatchDocument("cat city"s, 1);
+    ASSERT_EQUAL(memory_resource.allocation_count, index_allocation_count);
+    ASSERT_EQUAL(found_docs.size(), 1u);
+    ASSERT_EQUAL(found_docs[0].id, 1);
+    ASSERT(abs(found_docs[0].relevance - default_server.FindTopDocuments("cat city -dog"s)[0].relevance) < EPSILON);
+
+    // Копия использует тот же ресурс, присваивание между ресурсами сохраняет индекс.
+    const SearchServer copy = server;
+    ASSERT(copy.GetMemoryResource() == &memory_resource);
+    default_server = copy;
+    ASSERT(default_server.GetMemoryResource() == pmr::get_default_resource());
+    server = SearchServer("in the"s);
+    ASSERT_EQUAL(default_server.FindTopDocuments("cat"s).size(), 2u);
+    ASSERT_EQUAL(default_server.GetWordFrequencies(3).size(), 3u);
+}
+
+void TestRelevanceKernels() {
+    // Списки постингов слов запроса: отсортированные уникальные id, TF и IDF.
+    struct WordPostings {
+        vector<int> document_ids;
+        vector<double> term_freqs;
+        double inverse_document_freq;
+    };
+    mt19937 generator(42);
+    const int document_count = 1'000;
+    const auto generate_postings = [&generator](int size, double inverse_document_freq) {
+        WordPostings postings;
+        for (int id = 0; id < document_count; ++id) {
+            if (static_cast<int>(generator() % document_count) < size) {
+                postings.document_ids.push_back(id);
+                postings.term_freqs.push_back(1.0 / (1 + generator() % 20));
+            }
+        }
+        postings.inverse_document_freq = inverse_document_freq;
+        return postings;
+    };
+    // Длины списков не кратны ширине векторов, одно из слов встречается во всех документах.
+    const vector<WordPostings> plus_words = {
+        generate_postings(300, 1.2), generate_postings(45, 0.3), generate_postings(7, 2.5), generate_postings(120, 0),
+    };
+    const vector<WordPostings> minus_words = {generate_postings(60, 0), generate_postings(3, 0)};
+
+    // Эталон считается так же, как до векторизации: сумма TF * IDF по словам без минус-слов.
+    const auto compute_expected = [&](int first_id, int last_id) {
+        map<int, double> expected;
+        for (const WordPostings& word : plus_words) {
+            for (size_t i = 0; i < word.document_ids.size(); ++i) {
+                const int id = word.document_ids[i];
+                if (first_id <= id && id < last_id) {
+                    expected[id - first_id] += word.term_freqs[i] * word.inverse_document_freq;
+                }
+            }
+        }
+        for (const WordPostings& word : minus_words) {
+            for (const int id : word.document_ids) {
+                expected.erase(id - first_id);
+            }
+        }
+        return expected;
+    };
+
+    for (const SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        RelevanceAccumulator accumulator(level);
+        // Второй проход по части документов проверяет очистку после первого.
+        for (const auto& [first_id, last_id] : {pair(0, document_count), pair(250, 731), pair(0, document_count)}) {
+            const auto find_range = [first_id = first_id, last_id = last_id](const WordPostings& word) {
+                const auto begin = lower_bound(word.document_ids.begin(), word.document_ids.end(), first_id);
+                const auto end = lower_bound(begin, word.document_ids.end(), last_id);
+                return pair(static_cast<size_t>(begin - word.document_ids.begin()), static_cast<size_t>(end - begin));
+            };
+            accumulator.Reset(last_id - first_id);
+            for (const WordPostings& word : minus_words) {
+                const auto [begin, size] = find_range(word);
+                accumulator.Exclude(word.document_ids.data() + begin, size, first_id);
+            }
+            for (const WordPostings& word : plus_words) {
+                const auto [begin, size] = find_range(word);
+                accumulator.Add(word.document_ids.data() + begin, word.term_freqs.data() + begin, size,
+                                word.inverse_document_freq, first_id);
+            }
+            map<int, double> matched;
+            accumulator.ExtractMatched([&matched](int id, double relevance) {
+                matched.emplace(id, relevance);
+            });
+
+            const map<int, double> expected = compute_expected(first_id, last_id);
+            ASSERT_EQUAL(matched.size(), expected.size());
+            for (const auto& [id, relevance] : expected) {
+                ASSERT_EQUAL_HINT(matched.count(id), 1u, "Document "s + to_string(id));
+                ASSERT(abs(matched.at(id) - relevance) < EPSILON);
+            }
+        }
+
+        // Редкие совпадения среди множества документов извлекаются обходом постингов.
+        const vector<int> sparse_ids = {5, 40'000, 70'000};
+        const vector<double> sparse_term_freqs = {0.5, 0.25, 1.0};
+        accumulator.Reset(100'000);
+        accumulator.Exclude(sparse_ids.data() + 1, 1, 0);
+        accumulator.Add(sparse_ids.data(), sparse_term_freqs.data(), sparse_ids.size(), 2.0, 0);
+        accumulator.Add(sparse_ids.data() + 2, sparse_term_freqs.data(), 1, 2.0, 0);
+        map<int, double> sparse_matched;
+        accumulator.ExtractMatched([&sparse_matched](int id, double relevance) {
+            sparse_matched.emplace(id, relevance);
+        });
+        ASSERT(sparse_matched == (map<int, double>{{5, 1.0}, {70'000, 3.0}}));
+
+        // Запрос, прерванный до извлечения, не оставляет релевантности следующему.
+        accumulator.Reset(100'000);
+        accumulator.Add(sparse_ids.data(), sparse_term_freqs.data(), sparse_ids.size(), 2.0, 0);
+        accumulator.Reset(100'000);
+        accumulator.Add(sparse_ids.data(), sparse_term_freqs.data(), 1, 2.0, 0);
+        map<int, double> interrupted_matched;
+        accumulator.ExtractMatched([&interrupted_matched](int id, double relevance) {
+            interrupted_matched.emplace(id, relevance);
+        });
+        ASSERT(interrupted_matched == (map<int, double>{{5, 1.0}}));
+        accumulator.Reset(100'000);
+        accumulator.Add(sparse_ids.data() + 1, sparse_term_freqs.data() + 1, 2, 2.0, 0);
+        interrupted_matched.clear();
+        accumulator.ExtractMatched([&interrupted_matched](int id, double relevance) {
+            interrupted_matched.emplace(id, relevance);
+        });
+        ASSERT(interrupted_matched == (map<int, double>{{40'000, 0.5}, {70'000, 2.0}}));
+    }
+}
+
+// Функция TestSearchServer является точкой входа для запуска тестов
+void TestSearchServer() {
+    RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
+    RUN_TEST(TestDocumentsWithMinusWordsAreExcludedFromResults);
+    RUN_TEST(TestDocumentsAreSortedByItDescendingRelevance);
+    RUN_TEST(TestDocumentsRatingCalculations);
+    RUN_TEST(TestDocumentsFiltering);
+    RUN_TEST(TestFindTopDocumentsWithSpecificStatus);
+    RUN_TEST(TestDocsRelevanceAreCalculatedCorrectly);
+    RUN_TEST(TestSearchServerInitializer);
+    RUN_TEST(TestAddDocument);
+    RUN_TEST(TestSearchServerCopy);
+    RUN_TEST(TestMatchDocumentMethod);
+    RUN_TEST(TestMatchDocumentWithExecutionPolicy);
+    RUN_TEST(TestFindTopDocsWithInvalidQuery);
+    RUN_TEST(TestGetDocumentId);
+    RUN_TEST(TestDocumentsAddedInArbitraryIdOrder);
+    RUN_TEST(TestRemoveDocument);
+    RUN_TEST(TestRemoveDuplicates);
+    RUN_TEST(TestSnapshot);
+    RUN_TEST(TestFindTopDocumentsResultCount);
+    RUN_TEST(TestFindTopDocumentsOffset);
+    RUN_TEST(TestPaginator);
+    RUN_TEST(TestRequestQueue);
+    RUN_TEST(TestFindTopDocumentsWithExecutionPolicy);
+    RUN_TEST(TestProcessQueries);
+    RUN_TEST(TestInverseDocumentFreqRefreshInterval);
+    RUN_TEST(TestQueryCache);
+    RUN_TEST(TestSparseDocumentIdsAfterRemoval);
+    RUN_TEST(TestRelevanceKernels);
+    RUN_TEST(TestCompressedPostings);
+    RUN_TEST(TestTopDocumentQueryEvaluation);
+    RUN_TEST(TestTopDocumentCandidates);
+    RUN_TEST(TestDocumentFilter);
+    RUN_TEST(TestShardedSearchServer);
+    RUN_TEST(TestAddDocuments);
+    RUN_TEST(TestIngestDocuments);
+    RUN_TEST(TestConcurrentSearchServer);
+    RUN_TEST(TestMemoryResource);
+}
+
+int main() {
+    TestSearchServer();
+    return 0;
+}
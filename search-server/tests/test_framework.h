@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "printing.h"
+
+using namespace std;
+
+template <typename T, typename U>
+void AssertEqualImpl(const T& t, const U& u, const string& t_str, const string& u_str, const string& file,
+                     const string& func, unsigned line, const string& hint) {
+    if (t != u) {
+        cout << boolalpha;
+        cout << file << "("s << line << "): "s << func << ": "s;
+        cout << "ASSERT_EQUAL("s << t_str << ", "s << u_str << ") failed: "s;
+        cout << t << " != "s << u << "."s;
+        if (!hint.empty()) {
+            cout << " Hint: "s << hint;
+        }
+        cout << endl;
+        abort();
+    }
+}
+
+#define ASSERT_EQUAL(a, b) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, ""s)
+
+#define ASSERT_EQUAL_HINT(a, b, hint) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, (hint))
+
+inline void AssertImpl(bool value, const string& expr_str, const string& file, const string& func, unsigned line,
+                       const string& hint) {
+    if (!value) {
+        cout << file << "("s << line << "): "s << func << ": "s;
+        cout << "ASSERT("s << expr_str << ") failed."s;
+        if (!hint.empty()) {
+            cout << " Hint: "s << hint;
+        }
+        cout << endl;
+        abort();
+    }
+}
+
+#define ASSERT(expr) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, ""s)
+#define ASSERT_HINT(expr, hint) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, (hint))
+
+template <typename callable>
+void RunTestImpl(const callable& function, const string& function_string) {
+    function();
+    cerr << function_string << " "s << "OK" << endl;
+}
+
+#define RUN_TEST(func)  RunTestImpl(func, #func)
+
+
+inline void AssertThrowsImpl(const string& expr_str, const string& exception_str, const string& file, const string& func, unsigned line, const string& hint) {
+        cout << file << "("s << line << "): "s << func << ": "s;
+        cout << "ASSERT_THROWS("s << expr_str << ") expected to throw -> " << exception_str << " which it did not."s;
+        if (!hint.empty()) {
+            cout << " Hint: "s << hint;
+        }
+        cout << endl;
+        abort();
+}
+
+#define ASSERT_THROWS_HINT(expr, exception, hint)                                      \
+    try {                                                                              \
+        expr;                                                                          \
+        ASSERT_HINT(false, #exception + " should've been throwed"s);                   \
+    } catch(const exception& e){                                                       \
+    } catch(...) {                                                                     \
+        AssertThrowsImpl(#expr, #exception, __FILE__, __FUNCTION__, __LINE__, (hint)); \
+    }                                                                                  \
+
+#define ASSERT_THROWS(expr, exception) ASSERT_THROWS_HINT(expr, exception, "");
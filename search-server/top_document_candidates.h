@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+#include "document.h"
+
+using namespace std;
+
+// Documents that may be among the count best of those added one by one.
+// Relevances within EPSILON of the count-th best one are equal and are ordered
+// by rating later, so of such documents those with the best ratings are kept,
+// then those with the least ids, enough to fill count places. Memory is
+// proportional to count rather than to the number of added documents, even
+// when all of their relevances are equal.
+class TopDocumentCandidates {
+public:
+    TopDocumentCandidates(size_t count, pmr::memory_resource* memory_resource)
+        : count_(count), top_relevances_(memory_resource), documents_(memory_resource) {}
+
+    // Documents with lower relevance can't be among the best.
+    double GetThreshold() const {
+        return threshold_;
+    }
+
+    void Add(const Document& document) {
+        if (count_ == 0 || document.relevance < threshold_) {
+            return;
+        }
+        documents_.push_back(document);
+        if (top_relevances_.size() < count_) {
+            top_relevances_.push_back(document.relevance);
+            push_heap(top_relevances_.begin(), top_relevances_.end(), greater<>());
+        } else if (document.relevance > top_relevances_.front()) {
+            pop_heap(top_relevances_.begin(), top_relevances_.end(), greater<>());
+            top_relevances_.back() = document.relevance;
+            push_heap(top_relevances_.begin(), top_relevances_.end(), greater<>());
+        }
+        if (top_relevances_.size() == count_) {
+            threshold_ = top_relevances_.front() - EPSILON;
+        }
+        if (documents_.size() / 2 > count_) {
+            RemoveWorseDocuments();
+        }
+    }
+
+    pmr::vector<Document> Extract() {
+        RemoveWorseDocuments();
+        return move(documents_);
+    }
+
+private:
+    size_t count_;
+    // Relevance of the count best documents so far, the least one on top.
+    pmr::vector<double> top_relevances_;
+    pmr::vector<Document> documents_;
+    double threshold_ = -numeric_limits<double>::infinity();
+
+    void RemoveWorseDocuments() {
+        documents_.erase(remove_if(documents_.begin(), documents_.end(), [this](const Document& document) {
+            return document.relevance < threshold_;
+        }), documents_.end());
+        if (count_ == 0 || top_relevances_.size() < count_) {
+            return;
+        }
+        // Fewer than count documents are more relevant than the count-th best one,
+        // the rest of the places go to the documents tied with it.
+        const double tied_relevance = top_relevances_.front();
+        const auto tied_begin = partition(documents_.begin(), documents_.end(), [tied_relevance](const Document& document) {
+            return document.relevance >= tied_relevance + EPSILON;
+        });
+        const size_t tied_count = count_ - (tied_begin - documents_.begin());
+        if (static_cast<size_t>(documents_.end() - tied_begin) > tied_count) {
+            nth_element(tied_begin, tied_begin + tied_count, documents_.end(), [](const Document& lhs, const Document& rhs) {
+                return lhs.rating > rhs.rating || (lhs.rating == rhs.rating && lhs.id < rhs.id);
+            });
+            documents_.erase(tied_begin + tied_count, documents_.end());
+        }
+    }
+};